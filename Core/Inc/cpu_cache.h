@@ -0,0 +1,57 @@
+/*
+ * D-cache maintenance of the buffers shared with a DMA
+ *
+ * cpu_cache.h
+ *
+ * The ETH descriptors and buffers are in the .eth_dma section, a
+ * non-cacheable MPU region (see MPU_Config() and the linker script), they
+ * need no maintenance. A cacheable buffer handed to a DMA (e.g. a pbuf sent
+ * without copy) is cleaned before the transfer, so that the DMA reads what
+ * the CPU wrote. A cacheable buffer written by a DMA is invalidated before
+ * the CPU reads it.
+ */
+
+#ifndef __CPU_CACHE_H__
+#define __CPU_CACHE_H__
+
+#include "stm32f7xx_hal.h"
+
+/* Cortex-M7 D-cache line, bytes */
+#define CPU_CACHE_LINE		(32u)
+
+/**
+  * @brief  Writes the cached data of a buffer back to the memory
+  * @note   The range is extended to whole cache lines, a clean of the
+  *         neighbouring data is harmless.
+  * @param addr - start of the buffer
+  * @param len - bytes
+  * @retval None
+  */
+static inline void cpu_dcache_clean(const void* addr, uint32_t len)
+{
+	uint32_t start = (uint32_t)addr & ~(CPU_CACHE_LINE - 1u);
+	uint32_t end = (uint32_t)addr + len;
+
+	if (0 != len)
+	{
+		SCB_CleanDCache_by_Addr((uint32_t*)start, (int32_t)(end - start));
+	}
+}
+
+/**
+  * @brief  Drops the cached data of a buffer, the next read comes from the memory
+  * @note   The buffer must start and end on a cache line boundary
+  *         (CPU_CACHE_LINE), data sharing a line with it would be lost.
+  * @param addr - start of the buffer
+  * @param len - bytes
+  * @retval None
+  */
+static inline void cpu_dcache_invalidate(void* addr, uint32_t len)
+{
+	if (0 != len)
+	{
+		SCB_InvalidateDCache_by_Addr((uint32_t*)addr, (int32_t)len);
+	}
+}
+
+#endif /* __CPU_CACHE_H__ */
@@ -0,0 +1,59 @@
+/*
+ * CPU cycle probes
+ *
+ * cpu_cycles.h
+ *
+ * Counts the core clock cycles spent in a piece of code with the DWT cycle
+ * counter (CYCCNT, 216 MHz), e.g. to compare a build with the caches on and
+ * off, or with the hot functions in the flash and in ITCM (TCM_PLACEMENT).
+ * The probes cost a few cycles each, they are compiled in with
+ * CPU_CYCLES_PROBES.
+ *
+ * Usage:
+ *   CPU_CYCLES_BEGIN(start);
+ *   snake_move(&snake);
+ *   CPU_CYCLES_END(CPU_CYCLES_SNAKE_MOVE, start);
+ */
+
+#ifndef __CPU_CYCLES_H__
+#define __CPU_CYCLES_H__
+
+#include <stdint.h>
+
+#ifndef CPU_CYCLES_PROBES
+#define CPU_CYCLES_PROBES	0
+#endif
+
+typedef enum
+{
+	CPU_CYCLES_FILLRECT,		/* fillRect() */
+	CPU_CYCLES_PUSHCOLORS,		/* pushColors_any() */
+	CPU_CYCLES_SNAKE_MOVE,		/* snake_move(), snake_arena_move() */
+	CPU_CYCLES_ETH_RX,			/* low_level_input() */
+	CPU_CYCLES_LWIP_INPUT,		/* netif->input(), ethernet_input() to the TCP callbacks */
+	CPU_CYCLES_PROBES_NB
+} cpu_cycles_probe_e;
+
+typedef struct cpu_cycles_stats_tag
+{
+	uint32_t count;		/* measured runs */
+	uint32_t last;		/* cycles of the last run */
+	uint32_t max;
+	uint64_t sum;		/* sum/count = mean */
+} cpu_cycles_stats_t;
+
+void cpu_cycles_init(void);
+uint32_t cpu_cycles_now(void);
+void cpu_cycles_add(cpu_cycles_probe_e probe, uint32_t cycles);
+const cpu_cycles_stats_t* cpu_cycles_stats(cpu_cycles_probe_e probe);
+void cpu_cycles_print(void);
+
+#if CPU_CYCLES_PROBES
+#define CPU_CYCLES_BEGIN(start)			uint32_t start = cpu_cycles_now()
+#define CPU_CYCLES_END(probe, start)	cpu_cycles_add((probe), cpu_cycles_now() - (start))
+#else
+#define CPU_CYCLES_BEGIN(start)			((void)0)
+#define CPU_CYCLES_END(probe, start)	((void)0)
+#endif
+
+#endif /* __CPU_CYCLES_H__ */
@@ -0,0 +1,41 @@
+/*
+ * Tightly coupled memories placement
+ *
+ * tcm.h
+ *
+ * ITCM RAM (0x00000000, 16 KB) and DTCM RAM (0x20000000, 128 KB) are
+ * accessed by the core with zero wait states, out of the caches and of the
+ * AXI bus. The linker scripts collect the sections below, the startup code
+ * copies .itcm_text and .dtcm_data from the flash and zeroes .dtcm_bss.
+ *
+ * ITCM_FUNC  - function executed from ITCM (calls to/from the flash go
+ *              through the long branch veneers added by the linker)
+ * DTCM_DATA  - initialized variable in DTCM
+ * DTCM_BSS   - zero initialized variable in DTCM
+ * DTCM_CONST - constant table copied to DTCM (read without flash wait states)
+ *
+ * With TCM_PLACEMENT 0 the macros are empty - everything stays in the
+ * flash / SRAM1, e.g. to compare the cycle counts (cpu_cycles.h) of a
+ * function run from the flash (through the I-cache) and from ITCM.
+ */
+
+#ifndef __TCM_H__
+#define __TCM_H__
+
+#ifndef TCM_PLACEMENT
+#define TCM_PLACEMENT	1
+#endif
+
+#if TCM_PLACEMENT
+#define ITCM_FUNC		__attribute__((section(".itcm_text"), noinline))
+#define DTCM_DATA		__attribute__((section(".dtcm_data")))
+#define DTCM_BSS		__attribute__((section(".dtcm_bss")))
+#define DTCM_CONST		__attribute__((section(".dtcm_rodata")))
+#else
+#define ITCM_FUNC
+#define DTCM_DATA
+#define DTCM_BSS
+#define DTCM_CONST
+#endif
+
+#endif /* __TCM_H__ */
@@ -0,0 +1,48 @@
+/*
+ * Game tick scheduler
+ *
+ * tick_sched.h
+ *
+ * Fixed period tick driven by the TIM2 output compare (channel 1). TIM2 is
+ * a free running 32-bit counter at 1 MHz, the deadline of the next tick is
+ * always the previous deadline + period, so the tick does not drift with
+ * the duration of the game step or of the network processing.
+ *
+ * Usage:
+ *   tick_sched_start(150000);
+ *   while (1)
+ *   {
+ *     game_step();
+ *     tick_sched_wait(MX_LWIP_Process);	// slack: network, then WFI
+ *   }
+ */
+
+#ifndef __TICK_SCHED_H__
+#define __TICK_SCHED_H__
+
+#include <stdint.h>
+
+/* Frequency of the TIM2 time base (prescaler 107 at 108 MHz timer clock) */
+#define TICK_SCHED_TIMEBASE_HZ		(uint32_t)(1000000u)
+
+/* Work done in the slack of a tick (e.g. MX_LWIP_Process) */
+typedef void tick_sched_idle_fn(void);
+
+typedef struct tick_sched_stats_tag
+{
+	uint32_t ticks;		/* number of finished waits (ticks) */
+	uint32_t missed;	/* ticks whose deadline passed before the wait (overrun) */
+	uint32_t skipped;	/* whole periods dropped to get back on the tick grid */
+	uint32_t lateLast;	/* us between the deadline and the start of the tick */
+	uint32_t lateMax;
+	uint64_t lateSum;	/* lateSum/ticks = mean jitter */
+	uint32_t slackMin;	/* shortest slack left before a deadline, us */
+} tick_sched_stats_t;
+
+void tick_sched_start(uint32_t period_us);
+void tick_sched_wait(tick_sched_idle_fn* idle);
+uint32_t tick_sched_now(void);
+const tick_sched_stats_t* tick_sched_stats(void);
+void tick_sched_reset_stats(void);
+
+#endif /* __TICK_SCHED_H__ */
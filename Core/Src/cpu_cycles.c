@@ -0,0 +1,89 @@
+/*
+ * CPU cycle probes
+ *
+ * cpu_cycles.c
+ */
+
+#include "cpu_cycles.h"
+
+#include <stdio.h>
+
+#include "stm32f7xx_hal.h"
+
+static cpu_cycles_stats_t gProbes[CPU_CYCLES_PROBES_NB];
+
+static const char* const gProbeNames[CPU_CYCLES_PROBES_NB] =
+{
+	[CPU_CYCLES_FILLRECT] = "fillRect",
+	[CPU_CYCLES_PUSHCOLORS] = "pushColors_any",
+	[CPU_CYCLES_SNAKE_MOVE] = "snake_move",
+	[CPU_CYCLES_ETH_RX] = "low_level_input",
+	[CPU_CYCLES_LWIP_INPUT] = "lwip input",
+};
+
+
+/**
+  * @brief  Starts the DWT cycle counter
+  * @param  None
+  * @retval None
+  */
+void cpu_cycles_init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	/* DWT of the Cortex-M7 is write locked after reset */
+	DWT->LAR = 0xC5ACCE55u;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+
+uint32_t cpu_cycles_now(void)
+{
+	return DWT->CYCCNT;
+}
+
+
+/**
+  * @brief  Accounts a run of a probe
+  * @param probe - measured code
+  * @param cycles - cycles of the run (difference of two cpu_cycles_now())
+  * @retval None
+  */
+void cpu_cycles_add(cpu_cycles_probe_e probe, uint32_t cycles)
+{
+	cpu_cycles_stats_t* stats = &gProbes[probe];
+
+	stats->count++;
+	stats->last = cycles;
+	stats->sum += cycles;
+	if (cycles > stats->max)
+	{
+		stats->max = cycles;
+	}
+}
+
+
+const cpu_cycles_stats_t* cpu_cycles_stats(cpu_cycles_probe_e probe)
+{
+	return &gProbes[probe];
+}
+
+
+/**
+  * @brief  Prints the probes which ran (printf -> UART)
+  * @param  None
+  * @retval None
+  */
+void cpu_cycles_print(void)
+{
+	for (uint32_t probe = 0; probe < CPU_CYCLES_PROBES_NB; probe++)
+	{
+		const cpu_cycles_stats_t* stats = &gProbes[probe];
+
+		if (0 != stats->count)
+		{
+			printf("cycles %s runs:%lu last:%lu max:%lu avg:%lu\n", gProbeNames[probe],
+				   stats->count, stats->last, stats->max, (uint32_t)(stats->sum / stats->count));
+		}
+	}
+}
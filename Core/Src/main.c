@@ -29,9 +29,16 @@
 #include <stdio.h>
 
 #include "server_tcp.h"
+#include "server_udp.h"
+#include "lwip/stats.h"
 
 #include "tft.h"
 #include "snake_function.h"
+#include "snake_arena.h"
+#include "snake_journal.h"
+#include "tick_sched.h"
+#include "cpu_cycles.h"
+#include "tcm.h"
 
 #include "fonts.h"
 /* USER CODE END Includes */
@@ -44,6 +51,19 @@
 /* USER CODE BEGIN PD */
 #define DEBUG_EXECUTION_TIME 0
 
+/* Measure the pixel throughput of fillRect once at the start (UART) */
+#define TFT_FILL_BENCHMARK 0
+#define TFT_FILL_BENCHMARK_RUNS	(8u)
+
+/* Game tick period and the game over screen duration */
+#define SNAKE_TICK_PERIOD_US	(150000u)
+#define SNAKE_GAMEOVER_TICKS	(3000000u / SNAKE_TICK_PERIOD_US)
+
+/* Record each game tick into the journal (see snake_journal.h) */
+#define SNAKE_JOURNAL_RECORD 1
+/* Dump the journal over UART (huart3) once the game is over */
+#define SNAKE_JOURNAL_UART_DUMP 0
+
 #if DEBUG_EXECUTION_TIME
 #define STOPWATCH_INIT()		(HAL_TIM_Base_Start(&htim1))
 #define STOPWATCH_START() 		(htim1.Instance->CNT = 0)
@@ -71,9 +91,14 @@
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
+static void MPU_Config(void);
 /* USER CODE BEGIN PFP */
 void VS_DelayWithPolling(uint32_t Delay, fn_t func);
 void VS_SnakeGameLoop(void);
+void VS_SnakeArenaLoop(void);
+void VS_JournalDumpUart(void);
+void VS_TickStatsPrint(void);
+void VS_TftFillBenchmark(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -90,6 +115,15 @@ int main(void)
 
   /* USER CODE END 1 */
 
+  /* MPU Configuration--------------------------------------------------------*/
+  MPU_Config();
+
+  /* Enable I-Cache---------------------------------------------------------*/
+  SCB_EnableICache();
+
+  /* Enable D-Cache---------------------------------------------------------*/
+  SCB_EnableDCache();
+
   /* MCU Configuration--------------------------------------------------------*/
 
   /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
@@ -117,8 +151,15 @@ int main(void)
 
   /*Initialize dependencies for snake game (TFT, Randomizer)*/
   snake_hw_init();
+#if SNAKE_JOURNAL_RECORD
+  snake_journal_init(JOURNAL_RECORD);
+#endif
   /* Debug time execution timer */
   STOPWATCH_INIT();
+  cpu_cycles_init();
+#if TFT_FILL_BENCHMARK
+  VS_TftFillBenchmark();
+#endif
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -128,7 +169,11 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
+#if SNAKE_MULTIPLAYER
+	  VS_SnakeArenaLoop();
+#else
 	  VS_SnakeGameLoop();
+#endif
 
   }
   /* USER CODE END 3 */
@@ -195,26 +240,27 @@ int _write(int file, char *ptr, int len)
 	return len;
 }
 
-uint32_t VS_LWIP_Process_Wrapper(uint32_t optional_arg)
-{
-	MX_LWIP_Process();
-	return optional_arg;
-}
-
-
 /**
   * @brief  This function is the implementation of Snake Game (infinite loop game)
   * @param  None
   * @retval None
-  * @detail Game is played until crash happens
+  * @detail Game is played until crash happens. Game steps are paced by the
+  *         TIM2 tick scheduler, the network is processed in the slack.
   */
 void VS_SnakeGameLoop(void)
 {
-	  /*Snake (re)initiliazation */
-	  snake_t snake = { 0 };
-	  food_t food = { 0 };
+	  /*Snake (re)initiliazation - the game state is in DTCM */
+	  static snake_t snake DTCM_BSS;
+	  static food_t food DTCM_BSS;
+
+	  memset(&snake, 0, sizeof(snake));
+	  memset(&food, 0, sizeof(food));
 
 	  snake_init(&snake);
+	  snake_journal_game_start(&snake, &food);
+	  tcp_server_stream_game_start();
+
+	  tick_sched_start(SNAKE_TICK_PERIOD_US);
 
 	  while(1)
 	  {
@@ -224,15 +270,28 @@ void VS_SnakeGameLoop(void)
 		STOPWATCH_PRINT(1);
 
 		STOPWATCH_START();
+		CPU_CYCLES_BEGIN(moveStart);
 		snake_move(&snake);
+		CPU_CYCLES_END(CPU_CYCLES_SNAKE_MOVE, moveStart);
 		STOPWATCH_PRINT(2);
 
 		snake_inform(&snake, &food);
 
 		if (snake.state != PLAYING)
 		{
+			snake_journal_tick_end(&snake, &food);
+			tcp_server_stream_tick(&snake, &food);
+#if SNAKE_JOURNAL_UART_DUMP
+			VS_JournalDumpUart();
+#endif
+#if DEBUG_EXECUTION_TIME
+			VS_TickStatsPrint();
+#endif
 			/* Make time to let user read information */
-			snake_delay(3000, VS_LWIP_Process_Wrapper);
+			for (uint32_t tick = 0; tick < SNAKE_GAMEOVER_TICKS; tick++)
+			{
+				tick_sched_wait(MX_LWIP_Process);
+			}
 			break;
 		}
 
@@ -248,13 +307,191 @@ void VS_SnakeGameLoop(void)
 		snake_place_food(&snake, &food);
 		STOPWATCH_PRINT(5);
 
+		snake_journal_tick_end(&snake, &food);
+		tcp_server_stream_tick(&snake, &food);
+
 		STOPWATCH_START();
-		snake_delay(150, VS_LWIP_Process_Wrapper);
+		tick_sched_wait(MX_LWIP_Process);
 		STOPWATCH_PRINT(6);
 	  }
 }
+
+/**
+  * @brief  This function is the implementation of the multiplayer Snake Game (one round)
+  * @param  None
+  * @retval None
+  * @detail Each TCP client steers its own snake (see snake_arena.h), the round
+  *         is played until all the snakes crash. The journal and the game
+  *         state stream cover the single snake game only.
+  */
+void VS_SnakeArenaLoop(void)
+{
+	  /* Arena holds all the players' snakes - not on the stack, in DTCM */
+	  static snake_arena_t arena DTCM_BSS;
+
+	  snake_arena_init(&arena);
+
+	  tick_sched_start(SNAKE_TICK_PERIOD_US);
+
+	  while(1)
+	  {
+		STOPWATCH_START();
+		snake_arena_control(&arena);
+		CPU_CYCLES_BEGIN(moveStart);
+		snake_arena_move(&arena);
+		CPU_CYCLES_END(CPU_CYCLES_SNAKE_MOVE, moveStart);
+		STOPWATCH_PRINT(2);
+
+		snake_arena_inform(&arena);
+
+		if (arena.state != PLAYING)
+		{
+			/* Make time to let users read information */
+			for (uint32_t tick = 0; tick < SNAKE_GAMEOVER_TICKS; tick++)
+			{
+				tick_sched_wait(MX_LWIP_Process);
+			}
+			break;
+		}
+
+		STOPWATCH_START();
+		snake_arena_display(&arena);
+		snake_arena_place_food(&arena);
+		STOPWATCH_PRINT(4);
+
+		tick_sched_wait(MX_LWIP_Process);
+	  }
+}
+
+/**
+  * @brief  This function sends the game journal over UART (blocking)
+  * @param  None
+  * @retval None
+  * @detail Binary stream, see journal_hdr_t/journal_ckpt_t/journal_rec_t in snake_journal.h
+  */
+void VS_JournalDumpUart(void)
+{
+	uint8_t chunk[64];
+	uint32_t offset = 0;
+	uint32_t len;
+
+	while ((len = snake_journal_read(offset, chunk, sizeof(chunk))) != 0)
+	{
+		HAL_UART_Transmit(&huart3, chunk, (uint16_t)len, HAL_MAX_DELAY);
+		offset += len;
+	}
+}
+
+/**
+  * @brief  This function prints the tick scheduler, input queue, UDP control, ETH and lwIP heap counters (printf -> UART)
+  * @param  None
+  * @retval None
+  */
+void VS_TickStatsPrint(void)
+{
+	const tick_sched_stats_t* stats = tick_sched_stats();
+
+	printf("ticks:%lu missed:%lu skipped:%lu late[us] last:%lu max:%lu avg:%lu slack min:%lu\n",
+		   stats->ticks, stats->missed, stats->skipped, stats->lateLast, stats->lateMax,
+		   stats->ticks ? (uint32_t)(stats->lateSum / stats->ticks) : 0, stats->slackMin);
+
+	const snake_input_t* input = platform_input_stats();
+
+	printf("keys:%lu applied:%lu dropped:%lu coalesced:%lu stale:%lu latency max[ms]:%u\n",
+		   input->pushed, input->applied, input->dropped, input->coalesced, input->stale,
+		   input->latencyMax);
+
+	/* input-to-tick latency per path, bins 0, 1, 2~3, 4~7 ... ms */
+	for (uint32_t source = 0; source < INPUT_SOURCES; source++)
+	{
+		printf("%s latency:", (INPUT_SOURCE_UDP == source) ? "udp" : "tcp");
+		for (uint32_t bin = 0; bin < SNAKE_INPUT_HIST_BINS; bin++)
+		{
+			printf(" %lu", input->latencyHist[source][bin]);
+		}
+		printf("\n");
+	}
+
+#if SERVER_UDP_CONTROL
+	const struct server_udp_stats* udp = server_udp_stats();
+
+	printf("udp datagrams:%lu accepted:%lu duplicate:%lu stale:%lu invalid:%lu refused:%lu\n",
+		   udp->datagrams, udp->accepted, udp->duplicate, udp->stale, udp->invalid, udp->refused);
+#endif
+
+	const ethernetif_rx_stats_t* rx = ethernetif_rx_stats();
+
+	printf("eth rx zerocopy:%lu copied:%lu dropped:%lu resumed:%lu overruns:%lu\n",
+		   rx->zeroCopy, rx->copied, rx->dropped, rx->resumed, rx->overruns);
+	printf("eth rx irq:%lu drains:%lu frames/drain avg:%lu max:%lu lent max:%lu\n",
+		   rx->interrupts, rx->drains, rx->drains ? rx->frames / rx->drains : 0, rx->framesMax,
+		   rx->lentMax);
+
+	const ethernetif_tx_stats_t* tx = ethernetif_tx_stats();
+
+	printf("eth tx zerocopy:%lu copied:%lu busy:%lu\n", tx->zeroCopy, tx->copied, tx->busy);
+
+#if MEM_STATS
+	printf("heap used:%u max:%u err:%u\n",
+		   (unsigned)lwip_stats.mem.used, (unsigned)lwip_stats.mem.max, (unsigned)lwip_stats.mem.err);
+#endif
+
+	cpu_cycles_print();
+}
+
+/**
+  * @brief  This function measures the pixel throughput of fillRect - full
+  *         screen fills timed by the DWT cycle counter (printf -> UART)
+  * @param  None
+  * @retval None
+  */
+void VS_TftFillBenchmark(void)
+{
+	const uint32_t pixels = (uint32_t)width() * height() * TFT_FILL_BENCHMARK_RUNS;
+	uint32_t start = cpu_cycles_now();
+	uint32_t cycles;
+
+	for (uint32_t run = 0; run < TFT_FILL_BENCHMARK_RUNS; run++)
+	{
+		fillRect(0, 0, (int16_t)width(), (int16_t)height(), (run & 1u) ? WHITE : BLACK);
+	}
+	cycles = cpu_cycles_now() - start;
+
+	printf("fillRect %lu px: %lu cycles, %lu cycles/px x100, %lu kpx/s\n",
+		   pixels, cycles, (uint32_t)((100ull * cycles) / pixels),
+		   (uint32_t)(((uint64_t)pixels * (SystemCoreClock / 1000u)) / cycles));
+}
 /* USER CODE END 4 */
 
+/* MPU Configuration */
+
+void MPU_Config(void)
+{
+  MPU_Region_InitTypeDef MPU_InitStruct = {0};
+
+  /* Disables the MPU */
+  HAL_MPU_Disable();
+
+  /** Initializes and configures the Region and the memory to be protected
+  */
+  MPU_InitStruct.Enable = MPU_REGION_ENABLE;
+  MPU_InitStruct.Number = MPU_REGION_NUMBER0;
+  MPU_InitStruct.BaseAddress = 0x20070000;
+  MPU_InitStruct.Size = MPU_REGION_SIZE_64KB;
+  MPU_InitStruct.SubRegionDisable = 0x0;
+  MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+  MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+  MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+  MPU_InitStruct.IsShareable = MPU_ACCESS_SHAREABLE;
+  MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+  MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+
+  HAL_MPU_ConfigRegion(&MPU_InitStruct);
+  /* Enables the MPU */
+  HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+
+}
+
 /**
   * @brief  This function is executed in case of error occurrence.
   * @retval None
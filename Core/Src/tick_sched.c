@@ -0,0 +1,132 @@
+/*
+ * Game tick scheduler
+ *
+ * tick_sched.c
+ *
+ * The TIM2 compare interrupt only wakes the core from WFI, the deadline
+ * itself is checked against the counter, so a deadline which passed before
+ * the compare register was written is not lost.
+ */
+
+#include <string.h>
+
+#include "tick_sched.h"
+#include "tim.h"
+
+/* Tick period and absolute deadline of the next tick (TIM2 counts) */
+static uint32_t gPeriod;
+static uint32_t gDeadline;
+
+static tick_sched_stats_t gStats = { .slackMin = UINT32_MAX };
+
+
+static inline uint8_t tick_sched_elapsed(void)
+{
+	return (int32_t)(htim2.Instance->CNT - gDeadline) >= 0;
+}
+
+
+/* Current value of the time base, us */
+uint32_t tick_sched_now(void)
+{
+	return htim2.Instance->CNT;
+}
+
+
+/**
+  * @brief  Start the tick - the first tick is due right away
+  *
+  * @param period_us - tick period in microseconds
+  * @retval None
+  */
+void tick_sched_start(uint32_t period_us)
+{
+	/* TIM2 may already run (started by tft_init) - HAL_ERROR is harmless */
+	(void)HAL_TIM_Base_Start(&htim2);
+
+	gPeriod = period_us;
+	gDeadline = htim2.Instance->CNT;
+
+	__HAL_TIM_CLEAR_FLAG(&htim2, TIM_FLAG_CC1);
+	__HAL_TIM_ENABLE_IT(&htim2, TIM_IT_CC1);
+}
+
+
+/**
+  * @brief  Wait for the next tick, the idle work is done in the slack
+  *
+  * @note   The idle work is run at least once per tick (also after an
+  *         overrun), so the network is never starved by a long game step.
+  *         Between the idle calls the core sleeps in WFI until an interrupt
+  *         (TIM2 deadline, SysTick, UART, ...).
+  *
+  *         After an overrun the tick starts right away and the periods
+  *         which passed entirely are skipped, so the following ticks stay
+  *         on the original grid (no drift, no burst of catch-up ticks).
+  *
+  * @param idle - work for the slack, may be NULL
+  * @retval None
+  */
+void tick_sched_wait(tick_sched_idle_fn* idle)
+{
+	uint32_t now = htim2.Instance->CNT;
+	uint32_t late;
+
+	gDeadline += gPeriod;
+
+	if ((int32_t)(now - gDeadline) >= 0)
+	{
+		uint32_t behind = (now - gDeadline) / gPeriod;
+
+		gStats.missed++;
+		gStats.skipped += behind;
+		gDeadline += behind * gPeriod;
+	}
+	else if (gDeadline - now < gStats.slackMin)
+	{
+		gStats.slackMin = gDeadline - now;
+	}
+
+	__HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_1, gDeadline);
+
+	do
+	{
+		if (NULL != idle)
+		{
+			idle();
+		}
+
+		/* Interrupts are masked to not miss the wake-up between the check
+		 * and WFI, a pending interrupt still ends WFI */
+		__disable_irq();
+		if (!tick_sched_elapsed())
+		{
+			__WFI();
+		}
+		__enable_irq();
+
+	} while (!tick_sched_elapsed());
+
+	late = htim2.Instance->CNT - gDeadline;
+
+	gStats.ticks++;
+	gStats.lateLast = late;
+	gStats.lateSum += late;
+	if (late > gStats.lateMax)
+	{
+		gStats.lateMax = late;
+	}
+}
+
+
+const tick_sched_stats_t* tick_sched_stats(void)
+{
+	return &gStats;
+}
+
+
+void tick_sched_reset_stats(void)
+{
+	memset(&gStats, 0, sizeof(gStats));
+	gStats.slackMin = UINT32_MAX;
+}
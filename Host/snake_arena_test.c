@@ -0,0 +1,283 @@
+/*
+ * Crash scenarios of the multiplayer arena (snake_arena.c)
+ *
+ * snake_arena_test.c
+ *
+ * Plays short scripted rounds on the host port and checks after each tick
+ * that the occupancy map, the free cells set and the stub framebuffer match
+ * the bodies of the snakes still in play:
+ *
+ * - body : a snake runs into another one's body (phase 2), its old tail
+ *          cell lies next to the other snake
+ * - head : two heads enter the same cell (phase 3), a third snake looks on
+ * - detach: a player leaves after its tail cell was taken by another head
+ *
+ * A crashed snake has left its tail cell in phase 1 without entering the
+ * new head cell. The ring slot after its head is stale - after the ring
+ * wraps it holds a cell of an earlier move, the scenarios put a cell of
+ * a surviving snake there.
+ *
+ * usage: snake_arena_test
+ */
+
+#include <stdlib.h>
+
+#include "snake_arena.h"
+#include "snake_function.h"
+
+
+static snake_arena_t gArena;
+static const char* gScenario;
+static uint32_t gTick;
+static uint32_t gFailures;
+
+
+static void test_fail(const char* what, uint16_t x, uint16_t y)
+{
+	fprintf(stderr, "%s, tick %u: %s at %u,%u\n", gScenario, gTick, what, x, y);
+	gFailures++;
+}
+
+
+/* Occupancy, free cells and framebuffer must match the snakes in play */
+static void test_check(void)
+{
+	uint8_t expected[ARENA_CELLS] = { 0 };
+	uint16_t freeCount = 0;
+
+	for (uint8_t player = 0; player < SNAKE_PLAYERS_MAX; player++)
+	{
+		snake_player_t* pl = &gArena.player[player];
+		uint16_t pos = pl->tail;
+
+		if (!pl->spawned || PLAYING != pl->state)
+		{
+			continue;
+		}
+		for (uint16_t idx = 0; idx < pl->length; idx++, pos = SNAKE_RING_NEXT(pos))
+		{
+			expected[ARENA_CELL_IDX(pl->body[pos].x, pl->body[pos].y)] = player + 1;
+		}
+	}
+
+	for (uint16_t y = 0; y < ARENA_MAX_Y; y++)
+	{
+		for (uint16_t x = 0; x < ARENA_MAX_X; x++)
+		{
+			uint16_t idx = ARENA_CELL_IDX(x, y);
+			uint8_t owner = expected[idx];
+			char cell = host_port_cell(x, y);
+
+			if (gArena.owner[idx] != owner)
+			{
+				test_fail("owner", x, y);
+			}
+			if ((ARENA_OWNER_NONE == owner) ? (' ' != cell) : ((char)('1' + owner - 1) != cell))
+			{
+				test_fail("framebuffer", x, y);
+			}
+			if (ARENA_OWNER_NONE == owner && x >= FOOD_MIN_X && x <= FOOD_MAX_X &&
+				y >= FOOD_MIN_Y && y <= FOOD_MAX_Y)
+			{
+				freeCount++;
+				if (FREE_CELL_NONE == gArena.freeIndex[idx] || gArena.freeCells[gArena.freeIndex[idx]] != idx)
+				{
+					test_fail("free cells set", x, y);
+				}
+			}
+		}
+	}
+
+	if (gArena.freeCount != freeCount)
+	{
+		test_fail("free cells count", 0, 0);
+	}
+}
+
+
+/* New round with the players attached, the snakes are spawned paused */
+static void test_round(const char* scenario, uint8_t players)
+{
+	gScenario = scenario;
+	gTick = 0;
+
+	for (uint8_t player = 0; player < SNAKE_PLAYERS_MAX; player++)
+	{
+		if (player < players)
+		{
+			platform_player_attach(player);
+		}
+		else
+		{
+			platform_player_detach(player);
+		}
+	}
+
+	snake_arena_init(&gArena);
+	snake_arena_control(&gArena);
+	test_check();
+}
+
+
+/* One tick, the directions are given per player (0 = paused) */
+static void test_tick(const char* directions)
+{
+	for (uint8_t player = 0; player < SNAKE_PLAYERS_MAX && directions[player]; player++)
+	{
+		gArena.player[player].direction = ('.' == directions[player]) ? PAUSE : (snake_dir_e)directions[player];
+	}
+
+	gTick++;
+	snake_arena_move(&gArena);
+	snake_arena_display(&gArena);
+	test_check();
+}
+
+
+/* Stale ring slot after the head of the player holds the cell */
+static void test_stale_slot(uint8_t player, coord_t cell)
+{
+	snake_player_t* pl = &gArena.player[player];
+
+	pl->body[SNAKE_RING_NEXT(pl->head)] = cell;
+}
+
+
+static void test_expect(uint8_t player, snake_state_e state)
+{
+	if (gArena.player[player].state != state)
+	{
+		fprintf(stderr, "%s, tick %u: player %u state %u, expected %u\n",
+				gScenario, gTick, player, gArena.player[player].state, state);
+		gFailures++;
+	}
+}
+
+
+/*
+ * Player 1 runs along the row above player 2 and turns down into its tail,
+ * the old tail of player 1 is left next to the head of player 2:
+ *
+ *   1 1 1 .         . 1 1 1 <- tail left in the crash tick
+ *   2 2 2      ->   2 2 2
+ */
+static void test_body_crash(void)
+{
+	coord_t tail2;
+	uint16_t y1, y2;
+
+	test_round("body", 2);
+
+	y1 = gArena.player[0].body[gArena.player[0].head].y;
+	y2 = gArena.player[1].body[gArena.player[1].head].y;
+	tail2 = gArena.player[1].body[gArena.player[1].tail];
+
+	/* to the row above player 2, then back left along it */
+	test_tick("D.");
+	test_tick("D.");
+	test_tick("D.");
+	for (uint16_t y = y1; y + 1 < y2; y++)
+	{
+		test_tick("S.");
+	}
+	for (uint16_t move = 0; move < 5; move++)
+	{
+		test_tick("A.");
+	}
+	test_expect(0, PLAYING);
+
+	test_stale_slot(0, tail2);
+	test_tick("S.");
+
+	test_expect(0, CRASHED);
+	test_expect(1, PLAYING);
+}
+
+
+/*
+ * Players 1 and 2 turn towards each other into the same cell, player 3
+ * stays paused and its tail is in the stale slot of both crashed snakes.
+ */
+static void test_head_crash(void)
+{
+	coord_t tail3;
+	uint16_t y1, y2;
+
+	test_round("head", 3);
+
+	y1 = gArena.player[0].body[gArena.player[0].head].y;
+	y2 = gArena.player[1].body[gArena.player[1].head].y;
+	tail3 = gArena.player[2].body[gArena.player[2].tail];
+
+	/* both heads to the same column, then towards each other */
+	test_tick("DD.");
+	while (y2 - y1 > 2)
+	{
+		test_tick("SW.");
+		y1++;
+		y2--;
+	}
+	test_expect(0, PLAYING);
+	test_expect(1, PLAYING);
+
+	test_stale_slot(0, tail3);
+	test_stale_slot(1, tail3);
+	test_tick("SW.");
+
+	test_expect(0, CRASHED);
+	test_expect(1, CRASHED);
+	test_expect(2, PLAYING);
+}
+
+
+/*
+ * Player 2 runs along the row below player 1 and turns up into its tail
+ * cell in the tick player 1 moves on, then player 1 leaves the round:
+ *
+ *   1 1 1 .         2 1 1 1         2 . . .
+ *   2 2 2      ->   2 2        ->   2 2
+ */
+static void test_detach(void)
+{
+	uint16_t y1, y2;
+
+	test_round("detach", 2);
+
+	y1 = gArena.player[0].body[gArena.player[0].head].y;
+	y2 = gArena.player[1].body[gArena.player[1].head].y;
+
+	/* player 2 to the row below player 1, then left to its tail */
+	for (uint16_t y = y2; y > y1 + 1; y--)
+	{
+		test_tick(".W");
+	}
+	for (uint16_t move = 1; move < SNAKE_INIT_LNG; move++)
+	{
+		test_tick(".A");
+	}
+
+	test_tick("DW");
+	test_expect(0, PLAYING);
+	test_expect(1, PLAYING);
+
+	gTick++;
+	platform_player_detach(0);
+	snake_arena_control(&gArena);
+	test_check();
+
+	test_expect(0, CRASHED);
+	test_expect(1, PLAYING);
+}
+
+
+int main(void)
+{
+	snake_hw_init();
+
+	test_body_crash();
+	test_head_crash();
+	test_detach();
+
+	printf("arena: %s\n", gFailures ? "FAILED" : "passed");
+	return gFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
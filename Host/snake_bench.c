@@ -0,0 +1,366 @@
+/*
+ * Host microbenchmark of the snake game engine
+ *
+ * snake_bench.c
+ *
+ * Measures the per-tick cost of the engine (SnakeGame/snake_function.c)
+ * for growing snake lengths and compares it with a reference copy of the
+ * former implementation:
+ *
+ * - move : flat body shifted by memcpy + self-collision scan over the body
+ *          vs. ring buffer + occupancy bitmap
+ * - eat  : move + grow through a SNAKE_MAX_LNG stack copy of the body
+ *          vs. ring buffer tail step
+ * - food : rejection sampling with a body scan per draw
+ *          vs. single draw from the free cells set
+ * - arena: multiplayer tick (snake_arena.c) for 1 ~ SNAKE_PLAYERS_MAX snakes,
+ *          the cost per snake should not grow with the number of snakes
+ *
+ * The snake follows a Hamiltonian cycle of the arena, so it never crashes
+ * and any length up to SNAKE_WON_LIMIT can be reached. Results are ns per
+ * operation (host); the shape, not the absolute value, is of interest.
+ *
+ * usage: snake_bench [-n iterations]
+ */
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snake_function.h"
+#include "snake_arena.h"
+
+/* Consecutive eats timed as one batch (snake is restored between batches) */
+#define BENCH_EAT_BATCH		(uint16_t)(16u)
+
+/* Former implementation - flat body array, body[length - 1] is the head */
+typedef struct ref_snake_tag
+{
+	coord_t body[SNAKE_MAX_LNG];
+	uint16_t length;
+	coord_t ghost;
+	snake_state_e state;
+} ref_snake_t;
+
+
+static uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+
+/**
+  * @brief  Direction of the Hamiltonian cycle in the cell x, y
+  *
+  * @note   Row 0 is passed to the left, then the columns are passed down
+  *         (even x) and up (odd x) in rows 1 ~ ARENA_MAX_Y - 1. Requires
+  *         even ARENA_MAX_X.
+  */
+static snake_dir_e bench_cycle_dir(coord_t c)
+{
+	if (0 == c.y)
+	{
+		return (c.x > 0) ? LEFT : DOWN;
+	}
+	if (0 == (c.x & 1))
+	{
+		return (c.y < ARENA_MAX_Y - 1) ? DOWN : RIGHT;
+	}
+	if (c.y > 1)
+	{
+		return UP;
+	}
+	return (c.x == ARENA_MAX_X - 1) ? UP : RIGHT;
+}
+
+
+static coord_t bench_step(coord_t c, snake_dir_e dir)
+{
+	switch (dir)
+	{
+	case UP:	c.y--; break;
+	case DOWN:	c.y++; break;
+	case LEFT:	c.x--; break;
+	case RIGHT:	c.x++; break;
+	default:	break;
+	}
+	return c;
+}
+
+
+/* Former snake_move() - memcpy shift and scan of the whole body */
+static void ref_move(ref_snake_t* snake, snake_dir_e dir)
+{
+	coord_t next;
+
+	snake->ghost = snake->body[0];
+	memcpy(&snake->body[0], &snake->body[1], sizeof(coord_t) * (snake->length - 1));
+
+	next = bench_step(snake->body[snake->length - 1], dir);
+
+	for (int idx = 0; idx < snake->length; idx++)
+	{
+		if ((next.x == snake->body[idx].x) && (next.y == snake->body[idx].y))
+		{
+			snake->state = CRASHED;
+		}
+	}
+	snake->body[snake->length - 1] = next;
+}
+
+
+/* Former snake_haseaten() - grow through a temporary copy of the body */
+static void ref_haseaten(ref_snake_t* snake, food_t* food)
+{
+	if ((snake->body[snake->length - 1].x == food->coord.x)
+		&& (snake->body[snake->length - 1].y == food->coord.y))
+	{
+		coord_t tempSnake[SNAKE_MAX_LNG] = {0};
+		memcpy(tempSnake, &(snake->body[0]), (size_t)snake->length*sizeof(coord_t));
+
+		memcpy(&(snake->body[1]), tempSnake, (size_t)snake->length*sizeof(coord_t));
+		snake->body[0] = snake->ghost;
+		snake->length++;
+
+		food->state = EATEN;
+	}
+}
+
+
+/* Former generate_food() - rejection sampling, returns number of draws */
+static uint32_t ref_generate_food(ref_snake_t* snake, food_t* food)
+{
+	uint32_t draws = 0;
+	uint16_t isInvalid;
+	coord_t coords;
+
+	do
+	{
+		isInvalid = 0;
+		coords.x = (uint16_t)((platform_randomize() % (FOOD_MAX_X - FOOD_MIN_X + 1)) + FOOD_MIN_X);
+		coords.y = (uint16_t)((platform_randomize() % (FOOD_MAX_Y - FOOD_MIN_Y + 1)) + FOOD_MIN_Y);
+
+		for (int idx = 0; idx < snake->length; idx++)
+		{
+			if(0 == memcmp(&(snake->body[idx]), &coords, sizeof(coord_t)))
+			{
+				isInvalid = GENERAL_ERROR;
+				break;
+			}
+		}
+		draws++;
+	} while (isInvalid);
+
+	food->coord = coords;
+	platform_drawFood(coords.x, coords.y);
+
+	return draws;
+}
+
+
+/* Grow the engine's snake along the cycle up to the length */
+static void bench_grow_to(snake_t* snake, uint16_t length)
+{
+	food_t food = { 0 };
+
+	while (snake->length < length)
+	{
+		snake->direction = bench_cycle_dir(*snake_head(snake));
+		food.coord = bench_step(*snake_head(snake), snake->direction);
+		food.state = PLACED;
+		snake_move(snake);
+		snake_haseaten(snake, &food);
+	}
+}
+
+
+/* Copy the engine's snake into the reference (flat) representation */
+static void bench_to_ref(snake_t* snake, ref_snake_t* ref)
+{
+	for (uint16_t idx = 0; idx < snake->length; idx++)
+	{
+		ref->body[idx] = *snake_body_at(snake, idx);
+	}
+	ref->length = snake->length;
+	ref->ghost = snake->ghost;
+	ref->state = PLAYING;
+}
+
+
+/**
+  * @brief  Multiplayer tick cost for the number of players
+  *
+  * @note   Each snake runs around a 2x2 square next to its spawn cells,
+  *         its head always enters the cell just left by its tail.
+  */
+static void bench_arena(uint32_t iterations)
+{
+	static const snake_dir_e square[] = { DOWN, LEFT, UP, RIGHT };
+	static snake_arena_t arena;
+
+	printf("%7s | %9s | %s\n", "players", "tick", "per snake");
+
+	for (uint8_t players = 1; players <= SNAKE_PLAYERS_MAX; players++)
+	{
+		uint64_t t0, tick;
+
+		for (uint8_t player = 0; player < SNAKE_PLAYERS_MAX; player++)
+		{
+			if (player < players)
+			{
+				platform_player_attach(player);
+			}
+			else
+			{
+				platform_player_detach(player);
+			}
+		}
+
+		snake_arena_init(&arena);
+		snake_arena_control(&arena);
+
+		t0 = bench_now_ns();
+		for (uint32_t it = 0; it < iterations; it++)
+		{
+			for (uint8_t player = 0; player < players; player++)
+			{
+				arena.player[player].direction = square[it & 3];
+			}
+			snake_arena_move(&arena);
+			snake_arena_display(&arena);
+		}
+		tick = bench_now_ns() - t0;
+
+		if (PLAYING != arena.state)
+		{
+			fprintf(stderr, "arena: a snake crashed\n");
+		}
+
+		printf("%7u | %9.1f | %.1f\n", players,
+			   (double)tick / iterations, (double)tick / iterations / players);
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	static const uint16_t lengths[] = { 3, 25, 50, 100, 150, 200, SNAKE_WON_LIMIT };
+	uint32_t iterations = 200000;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n': iterations = (uint32_t)strtoul(optarg, NULL, 0); break;
+		default:
+			fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	host_port_seed(0xACE1u);
+	snake_hw_init();
+
+	printf("arena %ux%u, %u iterations, ns per operation (former / engine)\n",
+		   ARENA_MAX_X, ARENA_MAX_Y, iterations);
+	printf("%6s | %17s | %17s | %17s | %s\n", "length", "move", "eat", "food", "draws");
+
+	for (size_t l = 0; l < sizeof(lengths)/sizeof(lengths[0]); l++)
+	{
+		static snake_t snake, snapshot;
+		static ref_snake_t ref, refSnapshot;
+		food_t food = { 0 };
+		uint16_t length = lengths[l];
+		uint16_t eatLength = (length + BENCH_EAT_BATCH < SNAKE_WON_LIMIT) ? length : SNAKE_WON_LIMIT - BENCH_EAT_BATCH;
+		uint64_t t0, refMove, move, refEat = 0, eat = 0, refFood, foodNs;
+		uint64_t draws = 0;
+		uint32_t batches = iterations / BENCH_EAT_BATCH;
+
+		/* move - length stays constant, the snake runs around the cycle */
+		memset(&snake, 0, sizeof(snake));
+		snake_init(&snake);
+		bench_grow_to(&snake, length);
+		bench_to_ref(&snake, &ref);
+
+		t0 = bench_now_ns();
+		for (uint32_t it = 0; it < iterations; it++)
+		{
+			ref_move(&ref, bench_cycle_dir(ref.body[ref.length - 1]));
+		}
+		refMove = bench_now_ns() - t0;
+
+		t0 = bench_now_ns();
+		for (uint32_t it = 0; it < iterations; it++)
+		{
+			snake.direction = bench_cycle_dir(*snake_head(&snake));
+			snake_move(&snake);
+		}
+		move = bench_now_ns() - t0;
+
+		/* food - placement is forced on each call */
+		snake.direction = RIGHT;
+		t0 = bench_now_ns();
+		for (uint32_t it = 0; it < iterations; it++)
+		{
+			draws += ref_generate_food(&ref, &food);
+		}
+		refFood = bench_now_ns() - t0;
+
+		t0 = bench_now_ns();
+		for (uint32_t it = 0; it < iterations; it++)
+		{
+			food.state = EATEN;
+			food.time_elapsed = 1;
+			snake_place_food(&snake, &food);
+		}
+		foodNs = bench_now_ns() - t0;
+
+		/* eat - batches of consecutive eats, restored from a snapshot */
+		memset(&snapshot, 0, sizeof(snapshot));
+		snake_init(&snapshot);
+		bench_grow_to(&snapshot, eatLength);
+		bench_to_ref(&snapshot, &refSnapshot);
+
+		for (uint32_t b = 0; b < batches; b++)
+		{
+			memcpy(&ref, &refSnapshot, sizeof(ref));
+			t0 = bench_now_ns();
+			for (uint16_t it = 0; it < BENCH_EAT_BATCH; it++)
+			{
+				snake_dir_e dir = bench_cycle_dir(ref.body[ref.length - 1]);
+
+				food.coord = bench_step(ref.body[ref.length - 1], dir);
+				ref_move(&ref, dir);
+				ref_haseaten(&ref, &food);
+			}
+			refEat += bench_now_ns() - t0;
+
+			memcpy(&snake, &snapshot, sizeof(snake));
+			t0 = bench_now_ns();
+			for (uint16_t it = 0; it < BENCH_EAT_BATCH; it++)
+			{
+				snake.direction = bench_cycle_dir(*snake_head(&snake));
+				food.coord = bench_step(*snake_head(&snake), snake.direction);
+				food.state = PLACED;
+				snake_move(&snake);
+				snake_haseaten(&snake, &food);
+			}
+			eat += bench_now_ns() - t0;
+		}
+		batches = batches ? batches : 1;
+
+		printf("%6u | %7.1f / %7.1f | %7.1f / %7.1f | %7.1f / %7.1f | %.2f\n", length,
+			   (double)refMove / iterations, (double)move / iterations,
+			   (double)refEat / (batches * BENCH_EAT_BATCH), (double)eat / (batches * BENCH_EAT_BATCH),
+			   (double)refFood / iterations, (double)foodNs / iterations,
+			   (double)draws / iterations);
+	}
+
+	bench_arena(iterations);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,232 @@
+/*
+ * Host (PC) build of the snake game engine
+ *
+ * snake_host.c
+ *
+ * Runs the unchanged engine (SnakeGame/snake_function.c) on the headless
+ * host port with a scripted input and a seeded randomizer. The game loop
+ * is the same as VS_SnakeGameLoop() in Core/Src/main.c, only the 150 ms
+ * snake_delay() is replaced by advancing the virtual tick, so the game
+ * logic runs as fast as the host allows (profiling, benchmarking, fuzzing).
+ *
+ * usage: snake_host [-g games] [-s seed] [-k script] [-v] [-w file | -r file]
+ *
+ *   -g games  - number of games played one after another (default 1)
+ *   -s seed   - LFSR seed of the first game, next games use seed + n
+ *   -k script - input script, one key per tick, '.' = no key, repeated
+ *   -v        - print the arena after each game
+ *   -w file   - record the games and write the journal into the file
+ *   -r file   - replay a journal (e.g. dumped from the board by the 'J'
+ *               command over TCP or over UART), -g, -s and -k are ignored
+ */
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snake_function.h"
+#include "snake_journal.h"
+
+/* Game tick period of the MCU game loop */
+#define HOST_TICK_MS		(uint32_t)(150u)
+
+/* Default script - circle around a square of the arena (until the snake
+ * grows too long and bites itself) */
+#define HOST_DEFAULT_SCRIPT	"....S....A....W....D"
+
+/* Limit of ticks of a single game (scripts may never crash the snake) */
+#define HOST_MAX_TICKS		(uint32_t)(10000u)
+
+
+/**
+  * @brief  One game - copy of VS_SnakeGameLoop() without the delays
+  *
+  * @param snake - pointer to a snake structure
+  * @param food - pointer to a food structure
+  * @retval number of played ticks
+  */
+static uint32_t host_game(snake_t* snake, food_t* food)
+{
+	uint32_t ticks = 0;
+
+	snake_init(snake);
+	snake_journal_game_start(snake, food);
+
+	/* Game starts paused - "press" the pause key to run the snake */
+	platform_snake_set_control(PAUSE);
+
+	while (ticks < HOST_MAX_TICKS)
+	{
+		ticks++;
+
+		snake_control(snake);
+		snake_move(snake);
+
+		if (snake->state != PLAYING)
+		{
+			snake_journal_tick_end(snake, food);
+			break;
+		}
+
+		snake_haseaten(snake, food);
+		snake_display(snake);
+		snake_place_food(snake, food);
+
+		snake_journal_tick_end(snake, food);
+
+		host_port_advance_ms(HOST_TICK_MS);
+	}
+
+	return ticks;
+}
+
+
+/* Write the recorded journal into the file */
+static int host_journal_write(const char* path)
+{
+	FILE* file = fopen(path, "wb");
+	uint8_t chunk[256];
+	uint32_t offset = 0;
+	uint32_t len;
+
+	if (NULL == file)
+	{
+		perror(path);
+		return -1;
+	}
+	while ((len = snake_journal_read(offset, chunk, sizeof(chunk))) != 0)
+	{
+		fwrite(chunk, 1, len, file);
+		offset += len;
+	}
+	fclose(file);
+	printf("journal: %u bytes written into %s\n", offset, path);
+	return 0;
+}
+
+
+/* Load the journal from the file and switch it into replay */
+static int host_journal_load(const char* path)
+{
+	static uint8_t data[sizeof(journal_hdr_t) + sizeof(journal_ckpt_t) + 65535u*sizeof(journal_rec_t)];
+	FILE* file = fopen(path, "rb");
+	uint32_t count;
+	size_t len;
+
+	if (NULL == file)
+	{
+		perror(path);
+		return -1;
+	}
+	len = fread(data, 1, sizeof(data), file);
+	fclose(file);
+
+	if (0 == (count = snake_journal_load(data, (uint32_t)len)))
+	{
+		fprintf(stderr, "%s: not a journal\n", path);
+		return -1;
+	}
+
+	/* Replay starts with a game start or a checkpoint, the journal must hold one */
+	if (!snake_journal_can_replay())
+	{
+		fprintf(stderr, "%s: no game start or checkpoint in the journal (%u ticks)\n", path, count);
+		return -1;
+	}
+	snake_journal_init(JOURNAL_REPLAY);
+	return 0;
+}
+
+
+int main(int argc, char** argv)
+{
+	uint32_t games = 1;
+	uint16_t seed = 0xACE1u;
+	const char* script = HOST_DEFAULT_SCRIPT;
+	int verbose = 0;
+	const char* recordPath = NULL;
+	const char* replayPath = NULL;
+	int opt;
+	uint64_t totalTicks = 0;
+	struct timespec start, stop;
+	double elapsed;
+
+	while ((opt = getopt(argc, argv, "g:s:k:vw:r:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'g': games = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 's': seed = (uint16_t)strtoul(optarg, NULL, 0); break;
+		case 'k': script = optarg; break;
+		case 'v': verbose = 1; break;
+		case 'w': recordPath = optarg; break;
+		case 'r': replayPath = optarg; break;
+		default:
+			fprintf(stderr, "usage: %s [-g games] [-s seed] [-k script] [-v] [-w file | -r file]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (NULL != replayPath)
+	{
+		if (host_journal_load(replayPath))
+		{
+			return EXIT_FAILURE;
+		}
+		/* Keys and randomizer come from the journal, play until its end */
+		games = UINT32_MAX;
+		script = NULL;
+	}
+	else if (NULL != recordPath)
+	{
+		snake_journal_init(JOURNAL_RECORD);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (uint32_t game = 0; game < games; game++)
+	{
+		snake_t snake = { 0 };
+		food_t food = { 0 };
+		uint32_t ticks;
+
+		host_port_seed((uint16_t)(seed + game));
+		host_port_script(script);
+		snake_hw_init();
+
+		ticks = host_game(&snake, &food);
+		totalTicks += ticks;
+
+		if (NULL != replayPath && JOURNAL_REPLAY != snake_journal_mode())
+		{
+			games = game + 1;
+		}
+
+		if (verbose)
+		{
+			printf("game %u: ticks %u, score %u, %s\n", game, ticks,
+				   snake.length - SNAKE_INIT_LNG,
+				   (WON == snake.state) ? "won" : (CRASHED == snake.state) ? "crashed" : "stopped");
+			host_port_print_arena(stdout);
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+	elapsed = (double)(stop.tv_sec - start.tv_sec) + (double)(stop.tv_nsec - start.tv_nsec) * 1e-9;
+
+	printf("%u games, %llu ticks, %.3f s, %.0f ticks/s\n", games,
+		   (unsigned long long)totalTicks, elapsed,
+		   (elapsed > 0.0) ? (double)totalTicks / elapsed : 0.0);
+
+	if (NULL != replayPath)
+	{
+		printf("journal: replayed, %u divergences\n", snake_journal_divergences());
+		return snake_journal_divergences() ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+	if (NULL != recordPath && host_journal_write(recordPath))
+	{
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
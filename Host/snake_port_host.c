@@ -0,0 +1,383 @@
+/*
+ * Headless host (PC) port for a snake game (snake_functions)
+ *
+ * snake_port_host.c
+ *
+ * Implementation of the platform_* API of SnakeGame/snake_port.h without
+ * any hardware:
+ *
+ * - display  : stub framebuffer of ARENA_MAX_X x ARENA_MAX_Y cells
+ * - tick     : virtual millisecond counter, advances by 1 ms each time it
+ *              is read, so snake_delay() finishes without real waiting
+ * - control  : scripted input - one character of the script per tick,
+ *              '.' = no key pressed, the script is repeated; keys go
+ *              through the same input queue as on the target
+ * - random   : the same LFSR as the MCU port, seeded by host_port_seed()
+ *              instead of an ADC noise sample
+ *
+ * All the port state is thread local, so independent games may run in
+ * parallel threads (see snake_sim.c). With HOST_PORT_NO_RENDER defined the
+ * framebuffer is compiled out and all the drawing functions are no-ops.
+ */
+
+#include <stdlib.h>
+
+#include "snake_port.h"
+#include "snake_journal.h"
+
+/* Seed used by platform_init_randomizer() */
+static _Thread_local uint16_t gHostSeed = 0xACE1u;
+
+/* Randomizer seed */
+static _Thread_local uint16_t gRandSeed;
+
+/* queue of keys controlling snake's direction */
+static _Thread_local snake_input_t gInput;
+
+/* Direction restored by the pause key */
+static _Thread_local snake_dir_e gPrevDirection = RIGHT;
+
+/* Queues and pause directions of the multiplayer arena players */
+static _Thread_local snake_input_t gPlayerInput[SNAKE_PLAYERS_MAX];
+static _Thread_local snake_dir_e gPlayerPrevDirection[SNAKE_PLAYERS_MAX];
+static _Thread_local uint8_t gPlayerAttached[SNAKE_PLAYERS_MAX];
+
+/* Input script and position of the next character */
+static _Thread_local const char* gScript;
+static _Thread_local uint32_t gScriptPos;
+
+/* Virtual millisecond tick */
+static _Thread_local uint32_t gMsTick;
+
+static void platform_apply_control(snake_dir_e* current, snake_dir_e* prev, snake_dir_e direction);
+
+#ifndef HOST_PORT_NO_RENDER
+/* Stub framebuffer - one character per arena cell */
+static _Thread_local char gArena[ARENA_MAX_Y][ARENA_MAX_X];
+#endif
+
+
+/**
+  * @brief  Set seed used by the randomizer (instead of the ADC noise)
+  *
+  * @param seed - LFSR seed, must not be 0
+  * @retval None
+  */
+void host_port_seed(uint16_t seed)
+{
+	gHostSeed = seed ? seed : 0xACE1u;
+}
+
+
+/**
+  * @brief  Set the input script (one character per tick, '.' = no key)
+  *
+  * @param keys - NUL terminated script, NULL to disable scripted input
+  * @retval None
+  */
+void host_port_script(const char* keys)
+{
+	gScript = keys;
+	gScriptPos = 0;
+}
+
+
+/* Current value of the virtual millisecond tick */
+uint32_t host_port_ms(void)
+{
+	return gMsTick;
+}
+
+
+/* Let the virtual time pass (e.g. one game tick period) */
+void host_port_advance_ms(uint32_t ms)
+{
+	gMsTick += ms;
+}
+
+
+/* Content of the stub framebuffer cell (' ' empty, 'o' body, '1'~ player's body, '*' food) */
+char host_port_cell(uint16_t x, uint16_t y)
+{
+#ifndef HOST_PORT_NO_RENDER
+	return gArena[y][x];
+#else
+	return ' ';
+#endif
+}
+
+
+/**
+  * @brief  Print the stub framebuffer as ASCII art
+  *
+  * @param out - output stream
+  * @retval None
+  */
+void host_port_print_arena(FILE* out)
+{
+#ifndef HOST_PORT_NO_RENDER
+	for (uint16_t y = 0; y < ARENA_MAX_Y; y++)
+	{
+		fputc('|', out);
+		fwrite(gArena[y], 1, ARENA_MAX_X, out);
+		fputs("|\n", out);
+	}
+#endif
+}
+
+
+void platform_snake_set_control(char c)
+{
+	platform_snake_set_control_from(c, INPUT_SOURCE_TCP);
+}
+
+
+void platform_snake_set_control_from(char c, snake_input_source_e source)
+{
+	(void)snake_input_push(&gInput, c, (uint16_t)gMsTick, source);
+}
+
+
+const snake_input_t* platform_input_stats(void)
+{
+	return &gInput;
+}
+
+
+void platform_player_attach(uint8_t player)
+{
+	snake_input_init(&gPlayerInput[player], SNAKE_INPUT_POLICY);
+	gPlayerPrevDirection[player] = RIGHT;
+	gPlayerAttached[player] = 1;
+}
+
+
+void platform_player_detach(uint8_t player)
+{
+	gPlayerAttached[player] = 0;
+}
+
+
+uint8_t platform_player_attached(uint8_t player)
+{
+	return gPlayerAttached[player];
+}
+
+
+void platform_player_set_control(uint8_t player, char c, snake_input_source_e source)
+{
+	(void)snake_input_push(&gPlayerInput[player], c, (uint16_t)gMsTick, source);
+}
+
+
+void platform_init_randomizer(void)
+{
+	gRandSeed = gHostSeed;
+}
+
+
+void platform_refresh_hw(void)
+{
+#ifndef HOST_PORT_NO_RENDER
+	memset(gArena, ' ', sizeof(gArena));
+#endif
+	gPrevDirection = RIGHT;
+	for (uint8_t player = 0; player < SNAKE_PLAYERS_MAX; player++)
+	{
+		gPlayerPrevDirection[player] = RIGHT;
+	}
+}
+
+
+#ifndef HOST_PORT_NO_RENDER
+
+
+void platform_drawCell(uint16_t x, uint16_t y)
+{
+	gArena[y][x] = 'o';
+}
+
+
+void platform_eraseCell(uint16_t x, uint16_t y)
+{
+	gArena[y][x] = ' ';
+}
+
+
+/* Arena players are drawn as their number '1' ~ '9' */
+void platform_drawPlayerCell(uint16_t x, uint16_t y, uint8_t player)
+{
+	gArena[y][x] = (char)('1' + player % 9);
+}
+
+
+void platform_drawFood(uint16_t x, uint16_t y)
+{
+	gArena[y][x] = '*';
+}
+
+
+void platform_eraseFood(uint16_t x, uint16_t y)
+{
+	gArena[y][x] = ' ';
+}
+#else
+void platform_drawCell(uint16_t x, uint16_t y) {}
+void platform_eraseCell(uint16_t x, uint16_t y) {}
+void platform_drawPlayerCell(uint16_t x, uint16_t y, uint8_t player) {}
+void platform_drawFood(uint16_t x, uint16_t y) {}
+void platform_eraseFood(uint16_t x, uint16_t y) {}
+#endif
+
+
+void platform_init(void)
+{
+	snake_input_init(&gInput, SNAKE_INPUT_POLICY);
+	platform_init_randomizer();
+	platform_refresh_hw();
+}
+
+
+void platform_showInformal(char* str, uint16_t length)
+{
+	fprintf(stderr, "%.*s", (int)length, str);
+}
+
+
+/* The same LFSR as the MCU port, so a seed gives the same game on both */
+uint16_t platform_randomize(void)
+{
+  uint16_t lsb;
+
+  lsb = gRandSeed & 1;
+  gRandSeed >>= 1;
+  if (lsb == 1)
+  {
+	  gRandSeed ^= 0xB400u;
+  }
+
+  return gRandSeed;
+}
+
+
+uint16_t platform_msTickGet(void)
+{
+	return (uint16_t)(gMsTick++);
+}
+
+
+void platform_fatal(void)
+{
+	platform_showInformal("FatalError\n", strlen("FatalError\n"));
+	exit(EXIT_FAILURE);
+}
+
+
+/**
+  * @brief  Function to set snake's direction
+  *
+  * @note   Same rules as the MCU port. The key is taken from the script
+  *         (if any), otherwise from platform_snake_set_control().
+  *
+  * @param snake - pointer to a snake structure
+  * @retval None
+  */
+void platform_get_control(snake_t * snake)
+{
+	snake_dir_e direction = 0;
+
+	if (NULL != gScript && '\0' != gScript[0])
+	{
+		char key = gScript[gScriptPos++];
+
+		if ('\0' == gScript[gScriptPos])
+		{
+			gScriptPos = 0;
+		}
+		if ('.' != key)
+		{
+			platform_snake_set_control(key);
+		}
+	}
+
+	direction = (snake_dir_e)snake_input_pop(&gInput, (uint16_t)gMsTick);
+	direction = (snake_dir_e)snake_journal_control((char)direction, &gRandSeed);
+
+	platform_apply_control(&snake->direction, &gPrevDirection, direction);
+}
+
+
+/**
+  * @brief  Function to set the direction of an arena player's snake
+  *
+  * @note   Same rules as platform_get_control(), the key is popped from
+  *         the player's queue (not journaled).
+  *
+  * @param player - player number, < SNAKE_PLAYERS_MAX
+  * @param direction - direction of the player's snake
+  * @retval None
+  */
+void platform_get_player_control(uint8_t player, snake_dir_e* direction)
+{
+	snake_dir_e key = (snake_dir_e)snake_input_pop(&gPlayerInput[player], (uint16_t)gMsTick);
+
+	platform_apply_control(direction, &gPlayerPrevDirection[player], key);
+}
+
+
+/* Casts a key into the direction/pause of a snake, 180° turns are refused */
+static void platform_apply_control(snake_dir_e* current, snake_dir_e* prev, snake_dir_e direction)
+{
+	if (direction == 0)
+	{
+		return;
+	}
+
+	if ((direction != LEFT) && (direction != RIGHT) && (direction != UP) &&
+		(direction != DOWN) && (direction != PAUSE) && (direction != QUIT))
+	{
+		*prev = *current;
+		*current = PAUSE;
+	}
+	else
+	{
+		if (direction == PAUSE)
+		{
+			if (*current != PAUSE)
+			{
+				*prev = *current;
+				*current = PAUSE;
+			}
+			else
+			{
+				*current = *prev;
+			}
+		}
+		else
+		{
+			if ((*current != PAUSE) &&
+				!(*current == LEFT && direction == RIGHT) &&
+				!(*current == RIGHT && direction == LEFT) &&
+				!(*current == UP && direction == DOWN) &&
+				!(*current == DOWN && direction == UP))
+			{
+				*current = direction;
+			}
+		}
+	}
+}
+
+
+void platform_display_border(void)
+{
+}
+
+
+void platform_print_text(char *str, uint16_t length, uint16_t color)
+{
+	if (WHITE == color)
+	{
+		platform_showInformal(str, length);
+		platform_showInformal("\n", 1);
+	}
+}
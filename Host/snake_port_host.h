@@ -0,0 +1,57 @@
+/*
+ * Headless host (PC) port for a snake game (snake_functions)
+ *
+ * snake_port_host.h
+ *
+ * Included by snake_port.h instead of the MCU dependencies (HAL, ADC,
+ * usart, TFT, TCP server) when SNAKE_HOST_PORT is defined. The engine
+ * (snake_function.c) is then compiled unchanged for the host, see
+ * Host/Makefile.
+ *
+ * Arena dimensions may be overridden from the command line, e.g.
+ * -DARENA_MAX_X=20 -DARENA_MAX_Y=30, to tune the game offline.
+ */
+#ifndef SNAKE_PORT_HOST_H_
+#define SNAKE_PORT_HOST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Colors passed to platform_print_text() (same values as TFT/functions.h) */
+#define	BLACK				0x0000
+#define GREEN				0x07E0
+#define MAGENTA				0xF81F
+#define WHITE				0xFFFF
+
+/* Maximal coordination X and Y axis for a cell (same as the TFT port) */
+#ifndef ARENA_MAX_X
+#define ARENA_MAX_X			(uint16_t)(14)
+#endif
+#ifndef ARENA_MAX_Y
+#define ARENA_MAX_Y			(uint16_t)(21)
+#endif
+#define ARENA_MIN_X			(uint16_t)(0)
+#define ARENA_MIN_Y			(uint16_t)(0)
+
+/* Maximal* coordination X and Y for a food cell */
+#define FOOD_MAX_X			(uint16_t)(ARENA_MAX_X - 1)
+#define FOOD_MIN_X			(uint16_t)(1)
+#define FOOD_MAX_Y			(uint16_t)(ARENA_MAX_Y - 1)
+#define FOOD_MIN_Y			(uint16_t)(1)
+
+/* Platform blocking delay constants used by snake_delay() */
+#define PLATFORM_MAX_DELAY	(uint32_t)(0xFFFFFFFFu)
+#define PLATFORM_TICK_FREQ	(uint32_t)(1u)
+
+/* No tightly coupled memories on the host */
+#define PLATFORM_FAST_FUNC
+
+/* Host port control - not part of the platform_* API used by the engine */
+void host_port_seed(uint16_t seed);
+void host_port_script(const char* keys);
+uint32_t host_port_ms(void);
+void host_port_advance_ms(uint32_t ms);
+char host_port_cell(uint16_t x, uint16_t y);
+void host_port_print_arena(FILE* out);
+
+#endif /* SNAKE_PORT_HOST_H_ */
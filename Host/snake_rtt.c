@@ -0,0 +1,227 @@
+/*
+ * Command round-trip benchmark of the snake TCP server
+ *
+ * snake_rtt.c
+ *
+ * Connects to the board (or any build of ServerTCP), turns the echo on and
+ * measures the time from sending a command to receiving its echo, for each
+ * combination of the client's TCP_NODELAY and the server's tuning of the
+ * connection (SERVER_TCP_CMD_NODELAY, SERVER_TCP_CMD_ACK_NOW):
+ *
+ * - single : write 1 byte, read 1 byte
+ * - pair   : write 1 byte twice, read 2 bytes - the second write is held
+ *            by the client's Nagle until the first one is acknowledged,
+ *            so a delayed ACK of the server shows up here
+ *
+ * The probe byte ('.') is not a command, the game ignores it. The server's
+ * tuning is toggled, the tool assumes the defaults of server_tcp.h
+ * (SERVER_TCP_NODELAY 1, SERVER_TCP_ACK_NOW 1) at the connection.
+ *
+ * usage: snake_rtt [-a address] [-p port] [-n probes]
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RTT_PROBE			'.'
+#define RTT_CMD_ECHO		'E'
+#define RTT_CMD_NODELAY		'N'
+#define RTT_CMD_ACK_NOW		'K'
+
+/* Bytes echoed for the commands are read out after this time */
+#define RTT_SETTLE_US		(200000u)
+
+
+static uint64_t rtt_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+
+static int rtt_cmp(const void* a, const void* b)
+{
+	uint64_t x = *(const uint64_t*)a;
+	uint64_t y = *(const uint64_t*)b;
+
+	return (x > y) - (x < y);
+}
+
+
+/* Send a command byte and drop everything echoed until now */
+static void rtt_command(int fd, char cmd)
+{
+	char buf[64];
+
+	if (0 != cmd && send(fd, &cmd, 1, 0) != 1)
+	{
+		perror("send");
+		exit(EXIT_FAILURE);
+	}
+
+	usleep(RTT_SETTLE_US);
+	while (recv(fd, buf, sizeof(buf), MSG_DONTWAIT) > 0)
+	{
+	}
+}
+
+
+static int rtt_read(int fd, size_t len)
+{
+	char buf[8];
+	size_t got = 0;
+
+	while (got < len)
+	{
+		ssize_t ret = recv(fd, buf, len - got, 0);
+
+		if (ret <= 0)
+		{
+			return -1;
+		}
+		got += (size_t)ret;
+	}
+	return 0;
+}
+
+
+/**
+  * @brief  Measure the round trip of the probes
+  *
+  * @param fd - connected socket, echo on
+  * @param pair - write two bytes per probe
+  * @param samples - probes round trip times, ns (sorted on return)
+  * @param probes - number of the probes
+  * @retval 0 ok, -1 connection lost
+  */
+static int rtt_measure(int fd, int pair, uint64_t* samples, uint32_t probes)
+{
+	const char probe = RTT_PROBE;
+
+	for (uint32_t it = 0; it < probes; it++)
+	{
+		uint64_t t0 = rtt_now_ns();
+
+		if (send(fd, &probe, 1, 0) != 1 || (pair && send(fd, &probe, 1, 0) != 1))
+		{
+			return -1;
+		}
+		if (rtt_read(fd, pair ? 2 : 1))
+		{
+			return -1;
+		}
+		samples[it] = rtt_now_ns() - t0;
+
+		/* probes are not back to back, as the commands of a player */
+		usleep(5000);
+	}
+
+	qsort(samples, probes, sizeof(samples[0]), rtt_cmp);
+	return 0;
+}
+
+
+int main(int argc, char** argv)
+{
+	const char* address = "192.168.100.1";
+	uint16_t port = 8000;
+	uint32_t probes = 200;
+	struct sockaddr_in addr = { 0 };
+	uint64_t* samples;
+	int serverNodelay = 1;
+	int serverAckNow = 1;
+	int fd;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "a:p:n:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'a': address = optarg; break;
+		case 'p': port = (uint16_t)strtoul(optarg, NULL, 0); break;
+		case 'n': probes = (uint32_t)strtoul(optarg, NULL, 0); break;
+		default:
+			fprintf(stderr, "usage: %s [-a address] [-p port] [-n probes]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (probes == 0 || inet_pton(AF_INET, address, &addr.sin_addr) != 1)
+	{
+		fprintf(stderr, "invalid address or number of probes\n");
+		return EXIT_FAILURE;
+	}
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+	{
+		perror("connect");
+		return EXIT_FAILURE;
+	}
+
+	samples = calloc(probes, sizeof(samples[0]));
+	if (NULL == samples)
+	{
+		return EXIT_FAILURE;
+	}
+
+	rtt_command(fd, RTT_CMD_ECHO);
+
+	printf("%s:%u, %u probes, round trip us\n", address, port, probes);
+	printf("%-6s %-6s %-6s %-6s | %8s %8s %8s %8s\n",
+		   "client", "server", "server", "probe", "min", "median", "p99", "max");
+	printf("%-6s %-6s %-6s %-6s |\n", "nodel.", "nodel.", "acknow", "");
+
+	for (int config = 0; config < 8; config++)
+	{
+		int clientNodelay = (config >> 2) & 1;
+		int wantNodelay = (config >> 1) & 1;
+		int wantAckNow = config & 1;
+
+		if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &clientNodelay, sizeof(clientNodelay)) < 0)
+		{
+			perror("setsockopt");
+			return EXIT_FAILURE;
+		}
+		if (wantNodelay != serverNodelay)
+		{
+			rtt_command(fd, RTT_CMD_NODELAY);
+			serverNodelay = wantNodelay;
+		}
+		if (wantAckNow != serverAckNow)
+		{
+			rtt_command(fd, RTT_CMD_ACK_NOW);
+			serverAckNow = wantAckNow;
+		}
+
+		for (int pair = 0; pair <= 1; pair++)
+		{
+			if (rtt_measure(fd, pair, samples, probes))
+			{
+				fprintf(stderr, "connection lost\n");
+				return EXIT_FAILURE;
+			}
+
+			printf("%-6d %-6d %-6d %-6s | %8.0f %8.0f %8.0f %8.0f\n",
+				   clientNodelay, serverNodelay, serverAckNow, pair ? "pair" : "single",
+				   samples[0] / 1e3, samples[probes / 2] / 1e3,
+				   samples[(probes * 99) / 100] / 1e3, samples[probes - 1] / 1e3);
+		}
+	}
+
+	free(samples);
+	close(fd);
+	return EXIT_SUCCESS;
+}
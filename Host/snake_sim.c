@@ -0,0 +1,318 @@
+/*
+ * Headless batch simulator of the snake game
+ *
+ * snake_sim.c
+ *
+ * Plays N independent games (own snake_t/food_t each) on the host port with
+ * rendering compiled out (HOST_PORT_NO_RENDER) and reports the throughput,
+ * game lengths and score distribution. Games are spread over worker threads
+ * (all host cores by default), each worker plays one game at a time. All
+ * the engine/port state is per game or thread local, so the result does not
+ * depend on the number of workers.
+ *
+ * The tick period only converts ticks into the game time a player would
+ * spend, the arena size is selected at build time (make ARENA_X= ARENA_Y=).
+ *
+ * usage: snake_sim [-n games] [-j workers] [-s seed] [-t tick_ms]
+ *                  [-m max_ticks] [-i bot|random|script] [-k script]
+ *
+ *   bot    - random moves which do not crash immediately, food preferred
+ *   random - random key each 4th tick on average (crashes early)
+ *   script - script of keys, see snake_host.c (-k)
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snake_function.h"
+
+/* Number of bins of the printed score histogram */
+#define SIM_SCORE_BINS		(uint16_t)(10u)
+
+typedef enum { SIM_INPUT_BOT, SIM_INPUT_RANDOM, SIM_INPUT_SCRIPT } sim_input_e;
+
+typedef struct sim_result_tag
+{
+	uint32_t ticks;
+	uint16_t score;
+	snake_state_e state;
+} sim_result_t;
+
+typedef struct sim_config_tag
+{
+	uint32_t games;
+	uint32_t maxTicks;
+	uint16_t seed;
+	sim_input_e input;
+	const char* script;
+	sim_result_t* results;
+	atomic_uint next;
+} sim_config_t;
+
+
+/* Input randomizer of the simulated player (independent on the engine's LFSR) */
+static uint32_t sim_xorshift(uint32_t* state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+
+/* Cell x, y is inside the arena and not a part of the snake */
+static int sim_cell_free(snake_t* snake, int x, int y)
+{
+	uint16_t idx;
+
+	if (x < ARENA_MIN_X || y < ARENA_MIN_Y || x >= ARENA_MAX_X || y >= ARENA_MAX_Y)
+	{
+		return 0;
+	}
+	idx = (uint16_t)(y*ARENA_MAX_X + x);
+	return 0 == (snake->occupancy[idx >> 5] & ((uint32_t)1 << (idx & 31)));
+}
+
+
+/**
+  * @brief  Bot player - key of a random safe move, towards the food if possible
+  *
+  * @note   The tail cell is vacated by the move, still it is treated as busy
+  *         to keep the bot simple.
+  */
+static char sim_bot_key(snake_t* snake, food_t* food, uint32_t* rnd)
+{
+	static const struct { snake_dir_e dir; int dx; int dy; } moves[] =
+	{
+		{ UP, 0, -1 }, { DOWN, 0, 1 }, { LEFT, -1, 0 }, { RIGHT, 1, 0 }
+	};
+	coord_t* head = snake_head(snake);
+	char safe[4];
+	int safeCnt = 0;
+
+	for (int idx = 0; idx < 4; idx++)
+	{
+		int x = head->x + moves[idx].dx;
+		int y = head->y + moves[idx].dy;
+
+		if (!sim_cell_free(snake, x, y))
+		{
+			continue;
+		}
+		if (PLACED == food->state && x == food->coord.x && y == food->coord.y)
+		{
+			return (char)moves[idx].dir;
+		}
+		safe[safeCnt++] = (char)moves[idx].dir;
+	}
+
+	if (0 == safeCnt)
+	{
+		return 0;
+	}
+
+	/* Keep the direction mostly, turn sometimes */
+	for (int idx = 0; idx < safeCnt; idx++)
+	{
+		if (safe[idx] == (char)snake->direction && (sim_xorshift(rnd) & 3))
+		{
+			return 0;
+		}
+	}
+	return safe[sim_xorshift(rnd) % safeCnt];
+}
+
+
+/**
+  * @brief  One game - the same sequence as VS_SnakeGameLoop() without delays
+  */
+static void sim_game(sim_config_t* cfg, uint32_t game, sim_result_t* result)
+{
+	snake_t snake = { 0 };
+	food_t food = { 0 };
+	uint32_t rnd = 0x9E3779B9u ^ (game * 2654435761u);
+	uint32_t ticks = 0;
+
+	host_port_seed((uint16_t)(cfg->seed + game));
+	host_port_script((SIM_INPUT_SCRIPT == cfg->input) ? cfg->script : NULL);
+	snake_hw_init();
+	snake_init(&snake);
+
+	/* Game starts paused - "press" the pause key to run the snake */
+	platform_snake_set_control(PAUSE);
+
+	while (ticks < cfg->maxTicks)
+	{
+		ticks++;
+
+		if (ticks > 1)
+		{
+			if (SIM_INPUT_BOT == cfg->input)
+			{
+				char key = sim_bot_key(&snake, &food, &rnd);
+
+				if (key)
+				{
+					platform_snake_set_control(key);
+				}
+			}
+			else if (SIM_INPUT_RANDOM == cfg->input && 0 == (sim_xorshift(&rnd) & 3))
+			{
+				platform_snake_set_control("WASD"[sim_xorshift(&rnd) & 3]);
+			}
+		}
+
+		snake_control(&snake);
+		snake_move(&snake);
+
+		if (snake.state != PLAYING)
+		{
+			break;
+		}
+
+		snake_haseaten(&snake, &food);
+		snake_display(&snake);
+		snake_place_food(&snake, &food);
+	}
+
+	result->ticks = ticks;
+	result->score = snake.length - SNAKE_INIT_LNG;
+	result->state = snake.state;
+}
+
+
+static void* sim_worker(void* arg)
+{
+	sim_config_t* cfg = (sim_config_t*)arg;
+	uint32_t game;
+
+	while ((game = atomic_fetch_add(&cfg->next, 1)) < cfg->games)
+	{
+		sim_game(cfg, game, &cfg->results[game]);
+	}
+	return NULL;
+}
+
+
+static int sim_cmp_score(const void* a, const void* b)
+{
+	return (int)((const sim_result_t*)a)->score - (int)((const sim_result_t*)b)->score;
+}
+
+
+int main(int argc, char** argv)
+{
+	sim_config_t cfg = { .games = 10000, .maxTicks = 100000, .seed = 0xACE1u,
+						 .input = SIM_INPUT_BOT, .script = "....S....A....W....D" };
+	long workers = sysconf(_SC_NPROCESSORS_ONLN);
+	uint32_t tickMs = 150;
+	uint64_t totalTicks = 0, totalScore = 0;
+	uint32_t crashed = 0, won = 0, bins[SIM_SCORE_BINS] = { 0 };
+	uint16_t maxScore;
+	pthread_t* threads;
+	struct timespec start, stop;
+	double elapsed;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:j:s:t:m:i:k:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n': cfg.games = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'j': workers = strtol(optarg, NULL, 0); break;
+		case 's': cfg.seed = (uint16_t)strtoul(optarg, NULL, 0); break;
+		case 't': tickMs = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'm': cfg.maxTicks = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'k': cfg.script = optarg; cfg.input = SIM_INPUT_SCRIPT; break;
+		case 'i':
+			cfg.input = (0 == strcmp(optarg, "random")) ? SIM_INPUT_RANDOM :
+						(0 == strcmp(optarg, "script")) ? SIM_INPUT_SCRIPT : SIM_INPUT_BOT;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n games] [-j workers] [-s seed] [-t tick_ms] "
+					"[-m max_ticks] [-i bot|random|script] [-k script]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (0 == cfg.games)
+	{
+		return EXIT_SUCCESS;
+	}
+	if (workers < 1)
+	{
+		workers = 1;
+	}
+	if ((uint32_t)workers > cfg.games)
+	{
+		workers = (long)cfg.games;
+	}
+
+	cfg.results = calloc(cfg.games, sizeof(sim_result_t));
+	threads = calloc((size_t)workers, sizeof(pthread_t));
+	if (NULL == cfg.results || NULL == threads)
+	{
+		fprintf(stderr, "out of memory\n");
+		return EXIT_FAILURE;
+	}
+	atomic_init(&cfg.next, 0);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (long idx = 0; idx < workers; idx++)
+	{
+		pthread_create(&threads[idx], NULL, sim_worker, &cfg);
+	}
+	for (long idx = 0; idx < workers; idx++)
+	{
+		pthread_join(threads[idx], NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+	elapsed = (double)(stop.tv_sec - start.tv_sec) + (double)(stop.tv_nsec - start.tv_nsec) * 1e-9;
+
+	for (uint32_t game = 0; game < cfg.games; game++)
+	{
+		totalTicks += cfg.results[game].ticks;
+		totalScore += cfg.results[game].score;
+		crashed += (CRASHED == cfg.results[game].state);
+		won += (WON == cfg.results[game].state);
+	}
+
+	qsort(cfg.results, cfg.games, sizeof(sim_result_t), sim_cmp_score);
+	maxScore = cfg.results[cfg.games - 1].score;
+	for (uint32_t game = 0; game < cfg.games; game++)
+	{
+		bins[(uint32_t)cfg.results[game].score * SIM_SCORE_BINS / (maxScore + 1u)]++;
+	}
+
+	printf("arena %ux%u, %u games, %ld workers, tick %u ms\n",
+		   ARENA_MAX_X, ARENA_MAX_Y, cfg.games, workers, tickMs);
+	printf("time %.3f s, %.0f ticks/s, %.0f games/s\n", elapsed,
+		   (double)totalTicks / elapsed, (double)cfg.games / elapsed);
+	printf("game length avg %.1f ticks (%.1f s of play), crashed %u, won %u, stopped %u\n",
+		   (double)totalTicks / cfg.games, (double)totalTicks * tickMs / cfg.games / 1000.0,
+		   crashed, won, cfg.games - crashed - won);
+	printf("score min %u, avg %.1f, median %u, p90 %u, max %u\n",
+		   cfg.results[0].score, (double)totalScore / cfg.games,
+		   cfg.results[cfg.games / 2].score, cfg.results[(uint64_t)cfg.games * 9 / 10].score, maxScore);
+
+	for (uint16_t bin = 0; bin < SIM_SCORE_BINS; bin++)
+	{
+		uint32_t lo = (uint32_t)bin * (maxScore + 1u) / SIM_SCORE_BINS;
+		uint32_t hi = (uint32_t)(bin + 1) * (maxScore + 1u) / SIM_SCORE_BINS;
+
+		if (hi > lo)
+		{
+			printf("  score %4u ~ %4u: %u\n", lo, hi - 1, bins[bin]);
+		}
+	}
+
+	free(threads);
+	free(cfg.results);
+	return EXIT_SUCCESS;
+}
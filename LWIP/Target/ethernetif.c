@@ -32,7 +32,9 @@
 
 /* Within 'USER CODE' section, code will be kept by default at each generation */
 /* USER CODE BEGIN 0 */
-
+#include "cpu_cache.h"
+#include "cpu_cycles.h"
+#include "tcm.h"
 /* USER CODE END 0 */
 
 /* Private define ------------------------------------------------------------*/
@@ -42,32 +44,66 @@
 #define IFNAME1 't'
 
 /* USER CODE BEGIN 1 */
-
+/* Received frames are passed to lwIP in their Rx buffer and the descriptor
+ * is re-armed at once with a spare buffer, so frames kept by the stack
+ * (out-of-sequence segments, reassembly, echo) never stop the DMA. The buffer
+ * becomes a spare again when the stack frees the pbuf, while no spare is
+ * left the frames are copied into PBUF_POOL. */
+#define ETH_RX_SPARE_NB 8U
+
+/* Fragments of a frame shorter than this (the headers) are copied into the
+ * Tx_Buff of their descriptor, longer ones are sent by the DMA right from the
+ * pbuf, which is held until the descriptor of the frame is released. */
+#define ETH_TX_ZEROCOPY_MIN 64U
+
+/* Descriptors and buffers of the DMA: non-cacheable MPU region (MPU_Config) */
+#define ETH_DMA_SECTION __attribute__((section(".eth_dma")))
 /* USER CODE END 1 */
 
 /* Private variables ---------------------------------------------------------*/
 #if defined ( __ICCARM__ ) /*!< IAR Compiler */
   #pragma data_alignment=4
 #endif
-__ALIGN_BEGIN ETH_DMADescTypeDef  DMARxDscrTab[ETH_RXBUFNB] __ALIGN_END;/* Ethernet Rx MA Descriptor */
+__ALIGN_BEGIN ETH_DMADescTypeDef  DMARxDscrTab[ETH_RXBUFNB] __ALIGN_END ETH_DMA_SECTION;/* Ethernet Rx MA Descriptor */
 
 #if defined ( __ICCARM__ ) /*!< IAR Compiler */
   #pragma data_alignment=4
 #endif
-__ALIGN_BEGIN ETH_DMADescTypeDef  DMATxDscrTab[ETH_TXBUFNB] __ALIGN_END;/* Ethernet Tx DMA Descriptor */
+__ALIGN_BEGIN ETH_DMADescTypeDef  DMATxDscrTab[ETH_TXBUFNB] __ALIGN_END ETH_DMA_SECTION;/* Ethernet Tx DMA Descriptor */
 
 #if defined ( __ICCARM__ ) /*!< IAR Compiler */
   #pragma data_alignment=4
 #endif
-__ALIGN_BEGIN uint8_t Rx_Buff[ETH_RXBUFNB][ETH_RX_BUF_SIZE] __ALIGN_END; /* Ethernet Receive Buffer */
+__ALIGN_BEGIN uint8_t Rx_Buff[ETH_RXBUFNB][ETH_RX_BUF_SIZE] __ALIGN_END ETH_DMA_SECTION; /* Ethernet Receive Buffer */
 
 #if defined ( __ICCARM__ ) /*!< IAR Compiler */
   #pragma data_alignment=4
 #endif
-__ALIGN_BEGIN uint8_t Tx_Buff[ETH_TXBUFNB][ETH_TX_BUF_SIZE] __ALIGN_END; /* Ethernet Transmit Buffer */
+__ALIGN_BEGIN uint8_t Tx_Buff[ETH_TXBUFNB][ETH_TX_BUF_SIZE] __ALIGN_END ETH_DMA_SECTION; /* Ethernet Transmit Buffer */
 
 /* USER CODE BEGIN 2 */
+#if defined ( __ICCARM__ ) /*!< IAR Compiler */
+  #pragma data_alignment=4
+#endif
+__ALIGN_BEGIN static uint8_t RxSpareBuff[ETH_RX_SPARE_NB][ETH_RX_BUF_SIZE] __ALIGN_END ETH_DMA_SECTION; /* Spare Rx buffers */
 
+/* Rx buffer (Rx_Buff or RxSpareBuff) with the custom pbuf lending it to lwIP */
+typedef struct
+{
+  struct pbuf_custom pc;
+  uint8_t *buffer;
+} eth_rx_pbuf_t;
+
+static eth_rx_pbuf_t RxPbuf[ETH_RXBUFNB + ETH_RX_SPARE_NB];
+static eth_rx_pbuf_t *RxDescPbuf[ETH_RXBUFNB];    /* buffer of each descriptor (same index as DMARxDscrTab) */
+static eth_rx_pbuf_t *RxSpare[ETH_RX_SPARE_NB];   /* stack of the spare buffers */
+static uint32_t RxSpareCount;
+static ethernetif_rx_stats_t RxStats;
+static volatile uint8_t RxPending;  /* set by the Rx interrupt, cleared by the drain */
+
+/* Frame sent from its pbufs, held at its last Tx descriptor */
+static struct pbuf *TxPbuf[ETH_TXBUFNB];
+static ethernetif_tx_stats_t TxStats;
 /* USER CODE END 2 */
 
 /* Global Ethernet handle */
@@ -133,6 +169,9 @@ void HAL_ETH_MspInit(ETH_HandleTypeDef* ethHandle)
     GPIO_InitStruct.Alternate = GPIO_AF11_ETH;
     HAL_GPIO_Init(GPIOG, &GPIO_InitStruct);
 
+    /* Peripheral interrupt init */
+    HAL_NVIC_SetPriority(ETH_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(ETH_IRQn);
   /* USER CODE BEGIN ETH_MspInit 1 */
 
   /* USER CODE END ETH_MspInit 1 */
@@ -168,6 +207,9 @@ void HAL_ETH_MspDeInit(ETH_HandleTypeDef* ethHandle)
 
     HAL_GPIO_DeInit(GPIOG, RMII_TX_EN_Pin|RMII_TXD0_Pin);
 
+    /* Peripheral interrupt Deinit*/
+    HAL_NVIC_DisableIRQ(ETH_IRQn);
+
   /* USER CODE BEGIN ETH_MspDeInit 1 */
 
   /* USER CODE END ETH_MspDeInit 1 */
@@ -175,7 +217,132 @@ void HAL_ETH_MspDeInit(ETH_HandleTypeDef* ethHandle)
 }
 
 /* USER CODE BEGIN 4 */
+/**
+ * Gives the Rx descriptor(s) of a frame back to the DMA and resumes the
+ * reception if the DMA was suspended for the lack of a descriptor.
+ *
+ * @param desc first descriptor of the frame
+ * @param segments number of the descriptors of the frame
+ */
+static void ethernetif_rx_release(ETH_DMADescTypeDef *desc, uint32_t segments)
+{
+  /* the buffers were read out before the DMA may write them again */
+  __DMB();
+
+  while (segments-- > 0U)
+  {
+    desc->Status |= ETH_DMARXDESC_OWN;
+    desc = (ETH_DMADescTypeDef *)(desc->Buffer2NextDescAddr);
+  }
+
+  /* When Rx Buffer unavailable flag is set: clear it and resume reception */
+  if ((heth.Instance->DMASR & ETH_DMASR_RBUS) != (uint32_t)RESET)
+  {
+    /* Clear RBUS ETHERNET DMA flag */
+    heth.Instance->DMASR = ETH_DMASR_RBUS;
+    /* Resume DMA reception */
+    heth.Instance->DMARPDR = 0;
+    RxStats.resumed++;
+  }
+}
 
+/**
+ * pbuf_custom free callback of a frame received without copy, its buffer
+ * becomes a spare again.
+ *
+ * @param p the pbuf_custom of the frame (first member of eth_rx_pbuf_t)
+ */
+static void ethernetif_rx_pbuf_free(struct pbuf *p)
+{
+  RxSpare[RxSpareCount++] = (eth_rx_pbuf_t *)p;
+}
+
+/**
+ * Counters of the received frames.
+ */
+const ethernetif_rx_stats_t *ethernetif_rx_stats(void)
+{
+  return &RxStats;
+}
+
+/**
+ * Checks whether the next descriptor of the ring holds a received frame
+ * (not owned by the DMA).
+ */
+static uint8_t ethernetif_rx_ready(void)
+{
+  return (heth.RxDesc->Status & ETH_DMARXDESC_OWN) == (uint32_t)RESET;
+}
+
+/**
+ * Ethernet Rx Transfer completed callback (ETH_IRQHandler). Only flags the
+ * frames, they are passed to lwIP by ethernetif_input() in the main loop.
+ *
+ * @param heth ETH handle
+ */
+void HAL_ETH_RxCpltCallback(ETH_HandleTypeDef *heth)
+{
+  (void)heth;
+
+  RxPending = 1;
+  RxStats.interrupts++;
+}
+
+/**
+ * Frees the frames the DMA is done with (Own bit of the last descriptor
+ * of the frame cleared).
+ */
+static void ethernetif_tx_reclaim(void)
+{
+  for (uint32_t idx = 0; idx < ETH_TXBUFNB; idx++)
+  {
+    if ((TxPbuf[idx] != NULL) && ((DMATxDscrTab[idx].Status & ETH_DMATXDESC_OWN) == (uint32_t)RESET))
+    {
+      pbuf_free(TxPbuf[idx]);
+      TxPbuf[idx] = NULL;
+    }
+  }
+}
+
+/**
+ * Frees the frame still held by a descriptor being claimed. The DMA may
+ * finish the frame after ethernetif_tx_reclaim(), the cleared Own bit of
+ * the claimed descriptor shows it is done with the pbuf.
+ *
+ * @param desc the claimed Tx descriptor
+ */
+static void ethernetif_tx_claim(ETH_DMADescTypeDef *desc)
+{
+  uint32_t idx = desc - DMATxDscrTab;
+
+  if (TxPbuf[idx] != NULL)
+  {
+    pbuf_free(TxPbuf[idx]);
+    TxPbuf[idx] = NULL;
+  }
+}
+
+/**
+ * Checks whether the DMA may read a fragment in place.
+ *
+ * @param q the fragment
+ * @return 1 if it is long enough and in SRAM (not in the flash - PBUF_ROM)
+ */
+static uint8_t ethernetif_tx_zerocopy(const struct pbuf *q)
+{
+  uint32_t addr = (uint32_t)q->payload;
+
+  return (q->len >= ETH_TX_ZEROCOPY_MIN) &&
+         (addr >= RAMDTCM_BASE) && ((addr + q->len) <= (SRAM2_BASE + 0x4000UL));
+}
+
+/**
+ * Counters of the sent frames.
+ */
+const ethernetif_tx_stats_t *ethernetif_tx_stats(void)
+{
+  return &TxStats;
+}
 /* USER CODE END 4 */
 
 /*******************************************************************************
@@ -208,7 +375,7 @@ static void low_level_init(struct netif *netif)
   MACAddr[4] = 0x00;
   MACAddr[5] = 0x00;
   heth.Init.MACAddr = &MACAddr[0];
-  heth.Init.RxMode = ETH_RXPOLLING_MODE;
+  heth.Init.RxMode = ETH_RXINTERRUPT_MODE;
   heth.Init.ChecksumMode = ETH_CHECKSUM_BY_HARDWARE;
   heth.Init.MediaInterface = ETH_MEDIA_INTERFACE_RMII;
 
@@ -277,7 +444,24 @@ static void low_level_init(struct netif *netif)
 #endif /* LWIP_ARP || LWIP_ETHERNET */
 
 /* USER CODE BEGIN LOW_LEVEL_INIT */
+  /* Custom pbufs of the Rx buffers: Rx_Buff armed in the descriptors
+   * (HAL_ETH_DMARxDescListInit), RxSpareBuff on the spare stack */
+  RxSpareCount = 0;
+  for (uint32_t idx = 0; idx < ETH_RXBUFNB + ETH_RX_SPARE_NB; idx++)
+  {
+    RxPbuf[idx].pc.custom_free_function = ethernetif_rx_pbuf_free;
 
+    if (idx < ETH_RXBUFNB)
+    {
+      RxPbuf[idx].buffer = Rx_Buff[idx];
+      RxDescPbuf[idx] = &RxPbuf[idx];
+    }
+    else
+    {
+      RxPbuf[idx].buffer = RxSpareBuff[idx - ETH_RXBUFNB];
+      RxSpare[RxSpareCount++] = &RxPbuf[idx];
+    }
+  }
 /* USER CODE END LOW_LEVEL_INIT */
 }
 
@@ -301,66 +485,161 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
 {
   err_t errval;
   struct pbuf *q;
-  uint8_t *buffer = (uint8_t *)(heth.TxDesc->Buffer1Addr);
-  __IO ETH_DMADescTypeDef *DmaTxDesc;
-  uint32_t framelength = 0;
+  uint8_t *buffer = NULL;
+  ETH_DMADescTypeDef *DmaTxDesc;
+  ETH_DMADescTypeDef *LastTxDesc = NULL;
+  uint32_t descriptors = 0;
   uint32_t bufferoffset = 0;
   uint32_t byteslefttocopy = 0;
   uint32_t payloadoffset = 0;
+  uint32_t chunk;
+  uint8_t zerocopy = 0;
+
+  /* release the frames sent from their pbufs */
+  ethernetif_tx_reclaim();
+
   DmaTxDesc = heth.TxDesc;
-  bufferoffset = 0;
 
-  /* copy frame from pbufs to driver buffers */
+  /* point the descriptors to the pbufs, or copy the fragments to the driver buffers */
   for(q = p; q != NULL; q = q->next)
     {
-      /* Is this buffer available? If not, goto error */
-      if((DmaTxDesc->Status & ETH_DMATXDESC_OWN) != (uint32_t)RESET)
+      if (q->len == 0)
       {
-        errval = ERR_USE;
-        goto error;
+        continue;
+      }
+
+      if (ethernetif_tx_zerocopy(q))
+      {
+        /* Close the Tx buffer being filled */
+        if (buffer != NULL)
+        {
+          DmaTxDesc->ControlBufferSize = (bufferoffset & ETH_DMATXDESC_TBS1);
+          LastTxDesc = DmaTxDesc;
+          DmaTxDesc = (ETH_DMADescTypeDef *)(DmaTxDesc->Buffer2NextDescAddr);
+          buffer = NULL;
+        }
+
+        /* Is this descriptor available? If not, goto error */
+        if ((descriptors == ETH_TXBUFNB) || ((DmaTxDesc->Status & ETH_DMATXDESC_OWN) != (uint32_t)RESET))
+        {
+          errval = ERR_USE;
+          goto error;
+        }
+        descriptors++;
+        ethernetif_tx_claim(DmaTxDesc);
+
+        /* the pbuf is cacheable, the DMA reads the memory */
+        cpu_dcache_clean(q->payload, q->len);
+
+        DmaTxDesc->Buffer1Addr = (uint32_t)q->payload;
+        DmaTxDesc->ControlBufferSize = (q->len & ETH_DMATXDESC_TBS1);
+        LastTxDesc = DmaTxDesc;
+        DmaTxDesc = (ETH_DMADescTypeDef *)(DmaTxDesc->Buffer2NextDescAddr);
+        zerocopy = 1;
+        TxStats.zeroCopy++;
+        continue;
       }
 
       /* Get bytes in current lwIP buffer */
       byteslefttocopy = q->len;
       payloadoffset = 0;
 
-      /* Check if the length of data to copy is bigger than Tx buffer size*/
-      while( (byteslefttocopy + bufferoffset) > ETH_TX_BUF_SIZE )
+      while (byteslefttocopy > 0)
       {
-        /* Copy data to Tx buffer*/
-        memcpy( (uint8_t*)((uint8_t*)buffer + bufferoffset), (uint8_t*)((uint8_t*)q->payload + payloadoffset), (ETH_TX_BUF_SIZE - bufferoffset) );
+        /* Start filling the Tx buffer of the next descriptor */
+        if (buffer == NULL)
+        {
+          /* Is this descriptor available? If not, goto error */
+          if ((descriptors == ETH_TXBUFNB) || ((DmaTxDesc->Status & ETH_DMATXDESC_OWN) != (uint32_t)RESET))
+          {
+            errval = ERR_USE;
+            goto error;
+          }
+          descriptors++;
+          ethernetif_tx_claim(DmaTxDesc);
+
+          buffer = Tx_Buff[DmaTxDesc - DMATxDscrTab];
+          DmaTxDesc->Buffer1Addr = (uint32_t)buffer;
+          bufferoffset = 0;
+        }
 
-        /* Point to next descriptor */
-        DmaTxDesc = (ETH_DMADescTypeDef *)(DmaTxDesc->Buffer2NextDescAddr);
+        /* Copy data to Tx buffer */
+        chunk = LWIP_MIN(byteslefttocopy, ETH_TX_BUF_SIZE - bufferoffset);
+        memcpy( (uint8_t*)((uint8_t*)buffer + bufferoffset), (uint8_t*)((uint8_t*)q->payload + payloadoffset), chunk );
+        bufferoffset = bufferoffset + chunk;
+        payloadoffset = payloadoffset + chunk;
+        byteslefttocopy = byteslefttocopy - chunk;
 
-        /* Check if the buffer is available */
-        if((DmaTxDesc->Status & ETH_DMATXDESC_OWN) != (uint32_t)RESET)
+        /* Point to next descriptor once the buffer is full */
+        if (bufferoffset == ETH_TX_BUF_SIZE)
         {
-          errval = ERR_USE;
-          goto error;
+          DmaTxDesc->ControlBufferSize = (bufferoffset & ETH_DMATXDESC_TBS1);
+          LastTxDesc = DmaTxDesc;
+          DmaTxDesc = (ETH_DMADescTypeDef *)(DmaTxDesc->Buffer2NextDescAddr);
+          buffer = NULL;
         }
+      }
+      TxStats.copied++;
+    }
 
-        buffer = (uint8_t *)(DmaTxDesc->Buffer1Addr);
+  if (buffer != NULL)
+  {
+    DmaTxDesc->ControlBufferSize = (bufferoffset & ETH_DMATXDESC_TBS1);
+    LastTxDesc = DmaTxDesc;
+  }
 
-        byteslefttocopy = byteslefttocopy - (ETH_TX_BUF_SIZE - bufferoffset);
-        payloadoffset = payloadoffset + (ETH_TX_BUF_SIZE - bufferoffset);
-        framelength = framelength + (ETH_TX_BUF_SIZE - bufferoffset);
-        bufferoffset = 0;
-      }
+  if (LastTxDesc == NULL)
+  {
+    /* empty frame */
+    errval = ERR_OK;
+    goto error;
+  }
 
-      /* Copy the remaining bytes */
-      memcpy( (uint8_t*)((uint8_t*)buffer + bufferoffset), (uint8_t*)((uint8_t*)q->payload + payloadoffset), byteslefttocopy );
-      bufferoffset = bufferoffset + byteslefttocopy;
-      framelength = framelength + byteslefttocopy;
+  /* Hold the frame until the DMA has read its last descriptor */
+  if (zerocopy)
+  {
+    pbuf_ref(p);
+    TxPbuf[LastTxDesc - DMATxDscrTab] = p;
+  }
+
+  /* Prepare transmit descriptors to give to DMA: set the segment bits, the
+   * Own bit of the first descriptor goes last (the DMA may be polling) */
+  DmaTxDesc = heth.TxDesc;
+  for (;;)
+  {
+    uint32_t status = DmaTxDesc->Status & ~(ETH_DMATXDESC_FS | ETH_DMATXDESC_LS);
+
+    status |= (DmaTxDesc == heth.TxDesc) ? ETH_DMATXDESC_FS : ETH_DMATXDESC_OWN;
+    if (DmaTxDesc == LastTxDesc)
+    {
+      DmaTxDesc->Status = status | ETH_DMATXDESC_LS;
+      break;
     }
+    DmaTxDesc->Status = status;
+    DmaTxDesc = (ETH_DMADescTypeDef *)(DmaTxDesc->Buffer2NextDescAddr);
+  }
+  __DMB();
+  heth.TxDesc->Status |= ETH_DMATXDESC_OWN;
+  heth.TxDesc = (ETH_DMADescTypeDef *)(LastTxDesc->Buffer2NextDescAddr);
 
-  /* Prepare transmit descriptors to give to DMA */
-  HAL_ETH_TransmitFrame(&heth, framelength);
+  /* When Tx Buffer unavailable flag is set: clear it and resume transmission */
+  if ((heth.Instance->DMASR & ETH_DMASR_TBUS) != (uint32_t)RESET)
+  {
+    /* Clear TBUS ETHERNET DMA flag */
+    heth.Instance->DMASR = ETH_DMASR_TBUS;
+    /* Resume DMA transmission*/
+    heth.Instance->DMATPDR = 0;
+  }
 
   errval = ERR_OK;
 
 error:
 
+  if (errval == ERR_USE)
+  {
+    TxStats.busy++;
+  }
+
   /* When Transmit Underflow flag is set, clear it and issue a Transmit Poll Demand to resume transmission */
   if ((heth.Instance->DMASR & ETH_DMASR_TUS) != (uint32_t)RESET)
   {
@@ -381,7 +660,7 @@ error:
  * @return a pbuf filled with the received packet (including MAC header)
  *         NULL on memory error
    */
-static struct pbuf * low_level_input(struct netif *netif)
+static ITCM_FUNC struct pbuf * low_level_input(struct netif *netif)
 {
   struct pbuf *p = NULL;
   struct pbuf *q = NULL;
@@ -391,7 +670,8 @@ static struct pbuf * low_level_input(struct netif *netif)
   uint32_t bufferoffset = 0;
   uint32_t payloadoffset = 0;
   uint32_t byteslefttocopy = 0;
-  uint32_t i=0;
+  eth_rx_pbuf_t *rx;
+  uint32_t idx;
 
   /* get received frame */
   if (HAL_ETH_GetReceivedFrame(&heth) != HAL_OK)
@@ -401,6 +681,31 @@ static struct pbuf * low_level_input(struct netif *netif)
   /* Obtain the size of the packet and put it into the "len" variable. */
   len = heth.RxFrameInfos.length;
   buffer = (uint8_t *)heth.RxFrameInfos.buffer;
+  dmarxdesc = heth.RxFrameInfos.FSRxDesc;
+
+  /* A frame fitting one buffer is passed to lwIP in place and the descriptor
+   * goes back to the DMA at once with a spare buffer, the frame's buffer
+   * returns to the spares in ethernetif_rx_pbuf_free() */
+  if ((len > 0) && (heth.RxFrameInfos.SegCount == 1U) && (RxSpareCount > 0U))
+  {
+    idx = (ETH_DMADescTypeDef *)dmarxdesc - DMARxDscrTab;
+    rx = RxDescPbuf[idx];
+    p = pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &rx->pc, buffer, ETH_RX_BUF_SIZE);
+    if (p != NULL)
+    {
+      RxDescPbuf[idx] = RxSpare[--RxSpareCount];
+      dmarxdesc->Buffer1Addr = (uint32_t)RxDescPbuf[idx]->buffer;
+      ethernetif_rx_release((ETH_DMADescTypeDef *)dmarxdesc, 1);
+      heth.RxFrameInfos.SegCount = 0;
+
+      RxStats.zeroCopy++;
+      if (ETH_RX_SPARE_NB - RxSpareCount > RxStats.lentMax)
+      {
+        RxStats.lentMax = ETH_RX_SPARE_NB - RxSpareCount;
+      }
+      return p;
+    }
+  }
 
   if (len > 0)
   {
@@ -435,29 +740,19 @@ static struct pbuf * low_level_input(struct netif *netif)
       memcpy( (uint8_t*)((uint8_t*)q->payload + payloadoffset), (uint8_t*)((uint8_t*)buffer + bufferoffset), byteslefttocopy);
       bufferoffset = bufferoffset + byteslefttocopy;
     }
+    RxStats.copied++;
+  }
+  else
+  {
+    RxStats.dropped++;
   }
 
-    /* Release descriptors to DMA */
-    /* Point to first descriptor */
-    dmarxdesc = heth.RxFrameInfos.FSRxDesc;
-    /* Set Own bit in Rx descriptors: gives the buffers back to DMA */
-    for (i=0; i< heth.RxFrameInfos.SegCount; i++)
-    {
-      dmarxdesc->Status |= ETH_DMARXDESC_OWN;
-      dmarxdesc = (ETH_DMADescTypeDef *)(dmarxdesc->Buffer2NextDescAddr);
-    }
+  /* Release descriptors to DMA: set Own bit in Rx descriptors */
+  ethernetif_rx_release(heth.RxFrameInfos.FSRxDesc, heth.RxFrameInfos.SegCount);
 
-    /* Clear Segment_Count */
-    heth.RxFrameInfos.SegCount =0;
+  /* Clear Segment_Count */
+  heth.RxFrameInfos.SegCount =0;
 
-  /* When Rx Buffer unavailable flag is set: clear it and resume reception */
-  if ((heth.Instance->DMASR & ETH_DMASR_RBUS) != (uint32_t)RESET)
-  {
-    /* Clear RBUS ETHERNET DMA flag */
-    heth.Instance->DMASR = ETH_DMASR_RBUS;
-    /* Resume DMA reception */
-    heth.Instance->DMARPDR = 0;
-  }
   return p;
 }
 
@@ -470,26 +765,68 @@ static struct pbuf * low_level_input(struct netif *netif)
  *
  * @param netif the lwip network interface structure for this ethernetif
  */
-void ethernetif_input(struct netif *netif)
+ITCM_FUNC void ethernetif_input(struct netif *netif)
 {
   err_t err;
   struct pbuf *p;
+  uint32_t frames = 0;
+  uint32_t missed;
+
+  /* release the frames sent from their pbufs while the link is idle */
+  ethernetif_tx_reclaim();
+
+  if (!RxPending)
+  {
+    return;
+  }
+
+  /* Frames received after this point raise the flag again */
+  RxPending = 0;
 
-  /* move received packet into a new pbuf */
-  p = low_level_input(netif);
+  /* Drain the ring: every received frame in one pass, at most one lap so
+   * that a flood cannot hold the main loop */
+  while ((frames < ETH_RXBUFNB) && ethernetif_rx_ready())
+  {
+    frames++;
+
+    /* move received packet into a new pbuf */
+    CPU_CYCLES_BEGIN(rxStart);
+    p = low_level_input(netif);
+    CPU_CYCLES_END(CPU_CYCLES_ETH_RX, rxStart);
+
+    /* no packet could be read (no pbuf), it was dropped */
+    if (p == NULL) continue;
 
-  /* no packet could be read, silently ignore this */
-  if (p == NULL) return;
+    /* entry point to the LwIP stack */
+    CPU_CYCLES_BEGIN(inputStart);
+    err = netif->input(p, netif);
+    CPU_CYCLES_END(CPU_CYCLES_LWIP_INPUT, inputStart);
+
+    if (err != ERR_OK)
+    {
+      LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
+      pbuf_free(p);
+      p = NULL;
+    }
+  }
 
-  /* entry point to the LwIP stack */
-  err = netif->input(p, netif);
+  /* Frames left in the ring wait for the next call */
+  if (ethernetif_rx_ready())
+  {
+    RxPending = 1;
+  }
 
-  if (err != ERR_OK)
+  RxStats.drains++;
+  RxStats.frames += frames;
+  if (frames > RxStats.framesMax)
   {
-    LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
-    pbuf_free(p);
-    p = NULL;
+    RxStats.framesMax = frames;
   }
+
+  /* Frames lost for the lack of a descriptor or in the Rx FIFO (cleared on read) */
+  missed = heth.Instance->DMAMFBOCR;
+  RxStats.overruns += (missed & ETH_DMAMFBOCR_MFC) +
+                      ((missed & ETH_DMAMFBOCR_MFA) >> ETH_DMAMFBOCR_MFA_Pos);
 }
 
 #if !LWIP_ARP
@@ -26,7 +26,28 @@
 
 /* Within 'USER CODE' section, code will be kept by default at each generation */
 /* USER CODE BEGIN 0 */
+/* Counters of the received frames */
+typedef struct
+{
+  uint32_t zeroCopy;          /* passed to lwIP in the DMA buffer */
+  uint32_t copied;            /* copied into PBUF_POOL (no spare buffer) */
+  uint32_t dropped;           /* no pbuf for the frame */
+  uint32_t resumed;           /* DMA resumed after running out of descriptors */
+  uint32_t interrupts;        /* Rx interrupts */
+  uint32_t drains;            /* ethernetif_input() passes after an interrupt */
+  uint32_t frames;            /* frames read by the drains (frames / drains) */
+  uint32_t framesMax;         /* most frames read by one drain */
+  uint32_t overruns;          /* frames missed by the DMA (no descriptor, FIFO overflow) */
+  uint32_t lentMax;           /* most Rx buffers held by lwIP at once */
+} ethernetif_rx_stats_t;
 
+/* Counters of the sent frames */
+typedef struct
+{
+  uint32_t zeroCopy;          /* fragments read by the DMA from the pbuf */
+  uint32_t copied;            /* fragments copied into Tx_Buff */
+  uint32_t busy;              /* frames refused, no free descriptor */
+} ethernetif_tx_stats_t;
 /* USER CODE END 0 */
 
 /* Exported functions ------------------------------------------------------- */
@@ -41,6 +62,7 @@ u32_t sys_jiffies(void);
 u32_t sys_now(void);
 
 /* USER CODE BEGIN 1 */
-
+const ethernetif_rx_stats_t *ethernetif_rx_stats(void);
+const ethernetif_tx_stats_t *ethernetif_tx_stats(void);
 /* USER CODE END 1 */
 #endif
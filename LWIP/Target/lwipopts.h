@@ -97,7 +97,20 @@
 #define CHECKSUM_CHECK_ICMP6 0
 /*-----------------------------------------------------------------------------*/
 /* USER CODE BEGIN 1 */
+/* Heap and pool statistics (lwip_stats.mem, lwip_stats.memp[]) - to check
+ * that the application does not allocate in the steady state */
+#define SNAKE_LWIP_HEAP_STATS 0
 
+#if SNAKE_LWIP_HEAP_STATS
+#undef LWIP_STATS
+#define LWIP_STATS 1
+#endif
+
+/* Keepalive interval and count set per connection (tcp_server_tune) */
+#define LWIP_TCP_KEEPALIVE 1
+
+/* Received frames are handed to the stack in the ETH DMA buffers (ethernetif.c) */
+#define LWIP_SUPPORT_CUSTOM_PBUF 1
 /* USER CODE END 1 */
 
 #ifdef __cplusplus
@@ -6,16 +6,80 @@
  */
 
 #include "server_tcp.h"
+#include "snake_journal.h"
+#include "snake_stream.h"
+
+/* telnet (RFC 854) and terminal bytes handled by the parser */
+#define TELNET_SE     240
+#define TELNET_SB     250
+#define TELNET_WILL   251
+#define TELNET_DONT   254
+#define TELNET_IAC    255
+#define ASCII_ESC     0x1B
 
 static struct tcp_pcb *tcp_server_pcb;
 
+/* Snapshot of the game journal being sent, only one dump at a time */
+static uint8_t gJournalDump[SNAKE_JOURNAL_STREAM_MAX];
+static struct tcp_server_struct *gJournalDumpOwner;
+
+/* Connection pool, state ES_NONE = free */
+static struct tcp_server_struct gConnections[SERVER_TCP_MAX_CONN];
+static u32_t gRefused;          /* connections refused for the full pool */
+static u32_t gReaped;           /* connections closed for the idle timeout */
+
+/* Idle timeout in tcp_poll calls, interval 1 = each coarse TCP timer (500 ms) */
+#define SERVER_TCP_POLL_MS      500u
+#define SERVER_TCP_IDLE_POLLS   ((SERVER_TCP_IDLE_TIMEOUT_S * 1000u) / SERVER_TCP_POLL_MS)
+
+/* Tuning of the accepted connections */
+static struct tcp_server_tuning gTuning =
+{
+  SERVER_TCP_PRIO, SERVER_TCP_NODELAY, SERVER_TCP_ACK_NOW,
+  SERVER_TCP_KEEPALIVE_IDLE_MS, SERVER_TCP_KEEPALIVE_INTVL_MS, SERVER_TCP_KEEPALIVE_CNT
+};
+
+/* Game state stream - encoder and the frames of the recent ticks. Frames are
+ * written without a copy (lwIP references them by PBUF_ROM pbufs), so a slot
+ * is reused only when no client has its bytes unacknowledged (refs == 0). */
+struct tcp_server_stream_slot
+{
+  u8_t delta[SNAKE_STREAM_DELTA_MAX];
+  u8_t keyframe[SNAKE_STREAM_KEYFRAME_MAX];
+  u16_t deltaLen;
+  u16_t keyframeLen;      /* 0 = not encoded for this tick */
+  u8_t refs;              /* tx entries of clients referring to the slot */
+};
+
+static snake_stream_t gStream;
+static struct tcp_server_stream_slot gStreamSlots[SERVER_TCP_STREAM_SLOTS];
+static u8_t gStreamSlot;
+static u32_t gStreamCopies;     /* ticks sent by copy - all slots were in flight */
+
+/* Frames of a tick when no slot is free, written with TCP_WRITE_FLAG_COPY */
+static struct tcp_server_stream_slot gStreamCopy;
+
 static err_t tcp_server_accept(void *arg, struct tcp_pcb *newpcb, err_t err);
 static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err);
 static void tcp_server_error(void *arg, err_t err);
 static err_t tcp_server_poll(void *arg, struct tcp_pcb *tpcb);
 static err_t tcp_server_sent(void *arg, struct tcp_pcb *tpcb, u16_t len);
 static void tcp_server_send(struct tcp_pcb *tpcb, struct tcp_server_struct *es);
-static void tcp_server_connection_close(struct tcp_pcb *tpcb, struct tcp_server_struct *es);
+static err_t tcp_server_connection_close(struct tcp_pcb *tpcb, struct tcp_server_struct *es);
+static err_t tcp_server_write(struct tcp_pcb *tpcb, struct tcp_server_struct *es, const void *data, u16_t len, u8_t flags, u8_t slot);
+static void tcp_server_acked(struct tcp_server_struct *es, u16_t len);
+static void tcp_server_release_tx(struct tcp_server_struct *es);
+static char tcp_server_command_byte(char c);
+static char tcp_server_parse_byte(struct tcp_server_struct *es, u8_t c);
+static void tcp_server_parse(struct tcp_pcb *tpcb, struct tcp_server_struct *es, const char *data, u16_t len);
+static void tcp_server_command(struct tcp_pcb *tpcb, struct tcp_server_struct *es, char c);
+static void tcp_server_send_journal(struct tcp_pcb *tpcb, struct tcp_server_struct *es);
+static struct tcp_server_struct *tcp_server_conn_alloc(void);
+#if !SNAKE_MULTIPLAYER
+static struct tcp_server_struct *tcp_server_controller(void);
+#endif
+static void tcp_server_take_control(struct tcp_server_struct *es);
+static void tcp_server_release_player(struct tcp_server_struct *es);
 
 /**
   * @brief  Initializes the tcp  server
@@ -81,15 +145,23 @@ static err_t tcp_server_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
   /* set priority for the newly accepted tcp connection newpcb */
   tcp_setprio(newpcb, TCP_PRIO_MIN);
 
-  /* allocate structure es to maintain tcp connection informations */
-  es = (struct tcp_server_struct *)mem_malloc(sizeof(struct tcp_server_struct));
+  /* take a free structure es of the connection pool */
+  es = tcp_server_conn_alloc();
   if (es != NULL)
   {
+    memset(es, 0, sizeof(struct tcp_server_struct));
     es->state = ES_ACCEPTED;
     es->pcb = newpcb;
     es->p = NULL;
+    es->parseState = PS_DATA;
+    es->echo = SERVER_TCP_ECHO;
+
+    /* the first client controls the snake (each client its own snake in
+       the multiplayer arena), the others watch */
+    es->player = SERVER_TCP_NO_PLAYER;
+    tcp_server_take_control(es);
 
-    /* pass newly allocated es structure as argument to newpcb */
+    /* pass es structure as argument to newpcb */
     tcp_arg(newpcb, es);
 
     /* initialize lwip tcp_recv callback function for newpcb  */
@@ -101,17 +173,32 @@ static err_t tcp_server_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
     /* initialize lwip tcp_poll callback function for newpcb */
     tcp_poll(newpcb, tcp_server_poll, 1);
 
+    /* tcp_sent callback refreshes the idle timeout of listening-only clients */
+    tcp_sent(newpcb, tcp_server_sent);
+
+    /* Nagle, ACK policy, keepalive and priority of the pooled connection */
+    tcp_server_tune(es, &gTuning);
+
     ret_err = ERR_OK;
   }
   else
   {
-    /* return memory error */
-    ret_err = ERR_MEM;
+    /* pool is full - refuse the connection cleanly (message and FIN) */
+    gRefused++;
+    tcp_write(newpcb, SERVER_TCP_REFUSAL, sizeof(SERVER_TCP_REFUSAL) - 1, 0);
+    if (tcp_close(newpcb) == ERR_OK)
+    {
+      ret_err = ERR_OK;
+    }
+    else
+    {
+      tcp_abort(newpcb);
+      ret_err = ERR_ABRT;
+    }
   }
   return ret_err;
 }
 
-
 /**
   * @brief  This function is the implementation for tcp_recv LwIP callback
   * @param  arg: pointer on a argument for the tcp_pcb connection
@@ -123,6 +210,7 @@ static err_t tcp_server_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
 static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
 {
   struct tcp_server_struct *es;
+  struct pbuf *ptr;
   err_t ret_err;
 
   LWIP_ASSERT("arg != NULL",arg != NULL);
@@ -137,7 +225,7 @@ static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, er
     if(es->p == NULL)
     {
        /* we're done sending, close connection */
-       tcp_server_connection_close(tpcb, es);
+       return tcp_server_connection_close(tpcb, es);
     }
     else
     {
@@ -161,37 +249,55 @@ static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, er
     }
     ret_err = err;
   }
-  else if(es->state == ES_ACCEPTED)
+  else if ((es->state == ES_ACCEPTED) || (es->state == ES_RECEIVED))
   {
-    /* first data chunk in p->payload */
-    es->state = ES_RECEIVED;
+    if (es->state == ES_ACCEPTED)
+    {
+      /* first data chunk in p->payload */
+      es->state = ES_RECEIVED;
+
+      /* initialize LwIP tcp_sent callback function */
+      tcp_sent(tpcb, tcp_server_sent);
+    }
 
-    /* store reference to incoming pbuf (chain) */
-    es->p = p;
+    es->idlePolls = 0;
 
-    /* initialize LwIP tcp_sent callback function */
-    tcp_sent(tpcb, tcp_server_sent);
+    /* Binding with KeyBoard control - the whole chain is parsed in place */
+    for (ptr = p; ptr != NULL; ptr = ptr->next)
+    {
+#ifdef SERVER_TCP_PRINTF_ENABLED
+      printf("%.*s\n", (int)ptr->len, (const char*)ptr->payload);
+#endif
+      tcp_server_parse(tpcb, es, (const char*)ptr->payload, ptr->len);
+    }
 
-    /* send back the received data () */
-    tcp_server_send(tpcb, es);
+    /* input is consumed - reopen the receive window right away */
+    tcp_recved(tpcb, p->tot_len);
 
-    ret_err = ERR_OK;
-  }
-  else if (es->state == ES_RECEIVED)
-  {
-    /* more data received from client and previous data has been already sent*/
-    if(es->p == NULL)
+    /* ACK goes out with tcp_output at the end of tcp_input, the client's
+       next (Nagle-held) write does not wait for the delayed ACK timer */
+    if (es->ackNow)
     {
-      es->p = p;
-      /* send back received data */
-      tcp_server_send(tpcb, es);
+      tcp_set_flags(tpcb, TF_ACK_NOW);
+    }
+
+    if (es->echo)
+    {
+      if (es->p == NULL)
+      {
+        es->p = p;
+        /* send back the received data */
+        tcp_server_send(tpcb, es);
+      }
+      else
+      {
+        /* chain pbufs to the end of what is still to be echoed */
+        pbuf_chain(es->p, p);
+      }
     }
     else
     {
-      struct pbuf *ptr;
-      /* chain pbufs to the end of what we recv'ed previously  */
-      ptr = es->p;
-      pbuf_chain(ptr,p);
+      pbuf_free(p);
     }
     ret_err = ERR_OK;
   }
@@ -226,8 +332,23 @@ static void tcp_server_error(void *arg, err_t err)
   es = (struct tcp_server_struct *)arg;
   if (es != NULL)
   {
-    /*  free es structure */
-    mem_free(es);
+    if (gJournalDumpOwner == es)
+    {
+      gJournalDumpOwner = NULL;
+    }
+    /* pcb is already freed - nothing refers to the stream slots any more */
+    tcp_server_release_tx(es);
+    tcp_server_release_player(es);
+
+    /* data not echoed yet (may hold an Rx buffer of the Ethernet driver) */
+    if (es->p != NULL)
+    {
+      pbuf_free(es->p);
+      es->p = NULL;
+    }
+
+    /*  release es structure (and its role) */
+    es->state = ES_NONE;
   }
 }
 
@@ -256,7 +377,13 @@ static err_t tcp_server_poll(void *arg, struct tcp_pcb *tpcb)
       if(es->state == ES_CLOSING)
       {
         /*  close tcp connection */
-        tcp_server_connection_close(tpcb, es);
+        return tcp_server_connection_close(tpcb, es);
+      }
+      else if (++es->idlePolls >= SERVER_TCP_IDLE_POLLS)
+      {
+        /* reap the idle connection - frees its pool slot (and role) */
+        gReaped++;
+        return tcp_server_connection_close(tpcb, es);
       }
     }
     ret_err = ERR_OK;
@@ -280,10 +407,18 @@ static err_t tcp_server_sent(void *arg, struct tcp_pcb *tpcb, u16_t len)
 {
   struct tcp_server_struct *es;
 
-  LWIP_UNUSED_ARG(len);
-
   es = (struct tcp_server_struct *)arg;
 
+  /* acknowledged data - the client is alive, stream slots may be released */
+  es->idlePolls = 0;
+  tcp_server_acked(es, len);
+
+  if (es->journalSize != 0)
+  {
+    /* continue with the journal dump */
+    tcp_server_send_journal(tpcb, es);
+  }
+
   if(es->p != NULL)
   {
     /* still got pbufs to send */
@@ -293,14 +428,15 @@ static err_t tcp_server_sent(void *arg, struct tcp_pcb *tpcb, u16_t len)
   {
     /* if no more data to send and client closed connection*/
     if(es->state == ES_CLOSING)
-      tcp_server_connection_close(tpcb, es);
+      return tcp_server_connection_close(tpcb, es);
   }
   return ERR_OK;
 }
 
 
 /**
-  * @brief  This function is used to send data for tcp connection
+  * @brief  This function is used to echo the received data (debug echo mode),
+  *         the data has been already parsed and acknowledged by tcp_server_recv
   * @param  tpcb: pointer on the tcp_pcb connection
   * @param  es: pointer on _state structure
   * @retval None
@@ -319,26 +455,10 @@ static void tcp_server_send(struct tcp_pcb *tpcb, struct tcp_server_struct *es)
     ptr = es->p;
 
     /* enqueue data for transmission */
-    wr_err = tcp_write(tpcb, ptr->payload, ptr->len, 1);
+    wr_err = tcp_server_write(tpcb, es, ptr->payload, ptr->len, TCP_WRITE_FLAG_COPY, SERVER_TCP_SLOT_NONE);
 
     if (wr_err == ERR_OK)
     {
-      u16_t plen;
-
-      plen = ptr->len;
-
-      char *pReceived = (char*)mem_malloc((size_t)(plen + 1));
-      memcpy(pReceived, ptr->payload, plen);
-      memset(pReceived + plen, 0, 1);
-#ifdef SERVER_TCP_PRINTF_ENABLED
-      printf("%s\n", pReceived);
-#endif
-
-      /* Binding with KeyBoard control */
-      platform_snake_set_control(pReceived[0]);
-
-      mem_free(pReceived);
-
       /* continue with next pbuf in chain (if any) */
       es->p = ptr->next;
 
@@ -350,10 +470,6 @@ static void tcp_server_send(struct tcp_pcb *tpcb, struct tcp_server_struct *es)
 
       /* free pbuf: will free pbufs up to es->p (because es->p has a reference count > 0) */
       pbuf_free(ptr);
-
-      /* Update tcp window size to be advertized : should be called when received
-      data (with the amount plen) has been processed by the application layer */
-      tcp_recved(tpcb, plen);
    }
    else if(wr_err == ERR_MEM)
    {
@@ -369,12 +485,16 @@ static void tcp_server_send(struct tcp_pcb *tpcb, struct tcp_server_struct *es)
 
 /**
   * @brief  This functions closes the tcp connection
+  * @note   A connection with stream frames in flight is aborted instead, lwIP would
+  *         otherwise keep (re)sending the referenced slots after they are reused.
   * @param  tcp_pcb: pointer on the tcp connection
   * @param  es: pointer on _state structure
-  * @retval None
+  * @retval err_t: ERR_ABRT if the connection has been aborted, to be returned
+  *         by the calling lwIP callback
   */
-static void tcp_server_connection_close(struct tcp_pcb *tpcb, struct tcp_server_struct *es)
+static err_t tcp_server_connection_close(struct tcp_pcb *tpcb, struct tcp_server_struct *es)
 {
+  u8_t abort = 0;
 
   /* remove all callbacks */
   tcp_arg(tpcb, NULL);
@@ -386,9 +506,660 @@ static void tcp_server_connection_close(struct tcp_pcb *tpcb, struct tcp_server_
   /* delete es structure */
   if (es != NULL)
   {
-    mem_free(es);
+    if (gJournalDumpOwner == es)
+    {
+      gJournalDumpOwner = NULL;
+    }
+    abort = es->txSlotRefs != 0;
+    tcp_server_release_tx(es);
+    tcp_server_release_player(es);
+    es->state = ES_NONE;
+  }
+
+  if (abort)
+  {
+    tcp_abort(tpcb);
+    return ERR_ABRT;
   }
 
   /* close tcp connection */
   tcp_close(tpcb);
+  return ERR_OK;
+}
+
+/**
+  * @brief  This function maps a command byte of the plain data to a command
+  * @param  c: received byte
+  * @retval command, 0 = not a command
+  */
+static char tcp_server_command_byte(char c)
+{
+  /* keys are accepted in both cases */
+  if ((c >= 'a') && (c <= 'z'))
+  {
+    c = (char)(c - 'a' + 'A');
+  }
+
+  switch (c)
+  {
+  case UP:
+  case DOWN:
+  case LEFT:
+  case RIGHT:
+  case PAUSE:
+  case QUIT:
+  case SERVER_TCP_CMD_JOURNAL_DUMP:
+  case SERVER_TCP_CMD_JOURNAL_REPLAY:
+  case SERVER_TCP_CMD_ECHO:
+  case SERVER_TCP_CMD_STREAM:
+  case SERVER_TCP_CMD_CONTROL:
+  case SERVER_TCP_CMD_NODELAY:
+  case SERVER_TCP_CMD_ACK_NOW:
+    return c;
+  default:
+    return 0;
+  }
+}
+
+/**
+  * @brief  This function is a streaming parser of the received bytes
+  * @note   The state is kept in es, so a sequence may be split into more pbufs
+  *         or segments. Besides the command keys it handles:
+  *         - blanks and line endings of terminal clients (ignored)
+  *         - telnet IAC commands, option negotiation and subnegotiation (ignored)
+  *         - cursor keys ESC [ A..D and ESC O A..D (mapped to the directions)
+  * @param  es: pointer on _state structure
+  * @param  c: received byte
+  * @retval command, 0 = none (yet)
+  */
+static char tcp_server_parse_byte(struct tcp_server_struct *es, u8_t c)
+{
+  char cmd;
+
+  switch (es->parseState)
+  {
+  case PS_IAC:
+    if ((c >= TELNET_WILL) && (c <= TELNET_DONT))
+    {
+      es->parseState = PS_IAC_OPTION;
+    }
+    else if (c == TELNET_SB)
+    {
+      es->parseState = PS_IAC_SB;
+    }
+    else
+    {
+      /* IAC IAC is a data byte 0xFF, not a command either */
+      es->parseState = PS_DATA;
+    }
+    return 0;
+
+  case PS_IAC_OPTION:
+    es->parseState = PS_DATA;
+    return 0;
+
+  case PS_IAC_SB:
+    if (c == TELNET_IAC)
+    {
+      es->parseState = PS_IAC_SB_IAC;
+    }
+    return 0;
+
+  case PS_IAC_SB_IAC:
+    es->parseState = (c == TELNET_SE) ? PS_DATA : PS_IAC_SB;
+    return 0;
+
+  case PS_ESC:
+    if ((c == '[') || (c == 'O'))
+    {
+      es->parseState = PS_CSI;
+      return 0;
+    }
+    /* lone ESC, the byte is plain data again */
+    es->parseState = PS_DATA;
+    es->invalid++;
+    break;
+
+  case PS_CSI:
+    /* parameters and intermediates up to the final byte */
+    if ((c < 0x40) || (c > 0x7E))
+    {
+      return 0;
+    }
+    es->parseState = PS_DATA;
+    switch (c)
+    {
+    case 'A': return UP;
+    case 'B': return DOWN;
+    case 'C': return RIGHT;
+    case 'D': return LEFT;
+    default:
+      es->invalid++;
+      return 0;
+    }
+
+  default:
+    break;
+  }
+
+  /* PS_DATA */
+  if (c == TELNET_IAC)
+  {
+    es->parseState = PS_IAC;
+    return 0;
+  }
+  if (c == ASCII_ESC)
+  {
+    es->parseState = PS_ESC;
+    return 0;
+  }
+  /* line endings and blanks of terminal clients are not commands */
+  if ((c == '\r') || (c == '\n') || (c == ' ') || (c == '\t') || (c == '\0'))
+  {
+    return 0;
+  }
+  cmd = tcp_server_command_byte((char)c);
+  if (cmd == 0)
+  {
+    es->invalid++;
+  }
+  return cmd;
+}
+
+/**
+  * @brief  This function passes each byte of a received payload to the parser
+  * @note   The payload is read in place (no copy, no allocation), pbufs of a chain
+  *         are passed one by one by tcp_server_send
+  * @param  tpcb: pointer on the tcp_pcb connection
+  * @param  es: pointer on _state structure
+  * @param  data: payload of the pbuf
+  * @param  len: length of the payload
+  * @retval None
+  */
+static void tcp_server_parse(struct tcp_pcb *tpcb, struct tcp_server_struct *es, const char *data, u16_t len)
+{
+  u16_t idx;
+  char cmd;
+
+  es->rxBytes += len;
+
+  for (idx = 0; idx < len; idx++)
+  {
+    cmd = tcp_server_parse_byte(es, (u8_t)data[idx]);
+    if (cmd != 0)
+    {
+      es->commands++;
+      tcp_server_command(tpcb, es, cmd);
+    }
+  }
+}
+
+/**
+  * @brief  This function handles a received command byte
+  * @param  tpcb: pointer on the tcp_pcb connection
+  * @param  es: pointer on _state structure
+  * @param  c: received command byte
+  * @retval None
+  */
+static void tcp_server_command(struct tcp_pcb *tpcb, struct tcp_server_struct *es, char c)
+{
+  switch (c)
+  {
+  case SERVER_TCP_CMD_JOURNAL_DUMP:
+    /* snapshot of the journal is taken between two game ticks */
+    if (gJournalDumpOwner == NULL)
+    {
+      gJournalDumpOwner = es;
+      es->journalSize = snake_journal_read(0, gJournalDump, sizeof(gJournalDump));
+      es->journalOffset = 0;
+      tcp_server_send_journal(tpcb, es);
+    }
+    break;
+  case SERVER_TCP_CMD_JOURNAL_REPLAY:
+    /* the journal records the single snake game only */
+    if ((es->role == ES_ROLE_CONTROLLER) && !SNAKE_MULTIPLAYER)
+    {
+      snake_journal_request_replay();
+    }
+    else
+    {
+      es->invalid++;
+    }
+    break;
+  case SERVER_TCP_CMD_CONTROL:
+    if (es->role != ES_ROLE_CONTROLLER)
+    {
+      tcp_server_take_control(es);
+    }
+    break;
+  case SERVER_TCP_CMD_ECHO:
+    es->echo = !es->echo;
+    break;
+  case SERVER_TCP_CMD_NODELAY:
+    if (tcp_nagle_disabled(tpcb))
+    {
+      tcp_nagle_enable(tpcb);
+    }
+    else
+    {
+      tcp_nagle_disable(tpcb);
+    }
+    break;
+  case SERVER_TCP_CMD_ACK_NOW:
+    es->ackNow = !es->ackNow;
+    break;
+  case SERVER_TCP_CMD_STREAM:
+    es->stream = !es->stream;
+    if (es->stream)
+    {
+      /* frames are small and time critical - do not wait for ACKs (Nagle) */
+      tcp_nagle_disable(tpcb);
+      es->streamKeyframe = 1;
+    }
+    break;
+  default:
+    if (es->player != SERVER_TCP_NO_PLAYER)
+    {
+      platform_player_set_control(es->player, c, INPUT_SOURCE_TCP);
+    }
+    else if (es->role == ES_ROLE_CONTROLLER)
+    {
+      platform_snake_set_control(c);
+    }
+    else
+    {
+      /* spectators do not steer */
+      es->invalid++;
+    }
+    break;
+  }
+}
+
+/**
+  * @brief  This function sends as much of the journal dump as the send buffer allows,
+  *         the rest is sent from the tcp_sent callback
+  * @param  tpcb: pointer on the tcp_pcb connection
+  * @param  es: pointer on _state structure
+  * @retval None
+  */
+static void tcp_server_send_journal(struct tcp_pcb *tpcb, struct tcp_server_struct *es)
+{
+  while ((es->journalOffset < es->journalSize) && (tcp_sndbuf(tpcb) > 0))
+  {
+    u16_t len = (u16_t)LWIP_MIN((u32_t)tcp_sndbuf(tpcb), es->journalSize - es->journalOffset);
+
+    if (tcp_server_write(tpcb, es, &gJournalDump[es->journalOffset], len, TCP_WRITE_FLAG_COPY,
+                         SERVER_TCP_SLOT_NONE) != ERR_OK)
+    {
+      /* low on memory (queue length), try again from tcp_sent */
+      break;
+    }
+    es->journalOffset += len;
+  }
+
+  if (es->journalOffset >= es->journalSize)
+  {
+    es->journalSize = 0;
+    es->journalOffset = 0;
+    gJournalDumpOwner = NULL;
+  }
+}
+
+/**
+  * @brief  This function takes a free structure of the connection pool
+  * @param  None
+  * @retval pointer on _state structure, NULL if the pool is full
+  */
+static struct tcp_server_struct *tcp_server_conn_alloc(void)
+{
+  u16_t idx;
+
+  for (idx = 0; idx < SERVER_TCP_MAX_CONN; idx++)
+  {
+    if (gConnections[idx].state == ES_NONE)
+    {
+      return &gConnections[idx];
+    }
+  }
+  return NULL;
+}
+
+#if !SNAKE_MULTIPLAYER
+/**
+  * @brief  This function finds the connection controlling the snake
+  * @param  None
+  * @retval pointer on _state structure, NULL if there is no controller
+  */
+static struct tcp_server_struct *tcp_server_controller(void)
+{
+  u16_t idx;
+
+  for (idx = 0; idx < SERVER_TCP_MAX_CONN; idx++)
+  {
+    if ((gConnections[idx].state != ES_NONE) && (gConnections[idx].role == ES_ROLE_CONTROLLER))
+    {
+      return &gConnections[idx];
+    }
+  }
+  return NULL;
+}
+#endif
+
+/**
+  * @brief  This function finds the controlling connection of a remote host
+  * @note   Used to authorize the control datagrams (server_udp.c) - only a host
+  *         which holds the controller role over TCP may steer over UDP.
+  * @param  addr: remote IP address
+  * @retval pointer on _state structure, NULL if the host controls nothing
+  */
+struct tcp_server_struct *tcp_server_controller_of(const ip_addr_t *addr)
+{
+  u16_t idx;
+
+  for (idx = 0; idx < SERVER_TCP_MAX_CONN; idx++)
+  {
+    if ((gConnections[idx].state != ES_NONE) && (gConnections[idx].role == ES_ROLE_CONTROLLER) &&
+        ip_addr_cmp(&gConnections[idx].pcb->remote_ip, addr))
+    {
+      return &gConnections[idx];
+    }
+  }
+  return NULL;
+}
+
+/**
+  * @brief  This function sets the tuning of the connections accepted from now
+  * @param  tuning: pointer on the tuning, copied
+  * @retval None
+  */
+void tcp_server_set_tuning(const struct tcp_server_tuning *tuning)
+{
+  gTuning = *tuning;
+}
+
+/**
+  * @brief  This function tunes the pcb of a connection
+  * @note   Keepalive probes do not reset the idle timeout (SERVER_TCP_IDLE_TIMEOUT_S),
+  *         they only detect a dead peer earlier - lwIP then aborts the pcb (tcp_err).
+  *         The interval and count of the probes need LWIP_TCP_KEEPALIVE.
+  * @param  es: pointer on _state structure
+  * @param  tuning: pointer on the tuning
+  * @retval None
+  */
+void tcp_server_tune(struct tcp_server_struct *es, const struct tcp_server_tuning *tuning)
+{
+  struct tcp_pcb *tpcb = es->pcb;
+
+  tcp_setprio(tpcb, tuning->prio);
+
+  if (tuning->nodelay)
+  {
+    tcp_nagle_disable(tpcb);
+  }
+  else
+  {
+    tcp_nagle_enable(tpcb);
+  }
+
+  es->ackNow = tuning->ackNow;
+
+  if (tuning->keepIdleMs != 0)
+  {
+    ip_set_option(tpcb, SOF_KEEPALIVE);
+    tpcb->keep_idle = tuning->keepIdleMs;
+#if LWIP_TCP_KEEPALIVE
+    tpcb->keep_intvl = tuning->keepIntvlMs;
+    tpcb->keep_cnt = tuning->keepCnt;
+#endif
+  }
+  else
+  {
+    ip_reset_option(tpcb, SOF_KEEPALIVE);
+  }
+}
+
+/**
+  * @brief  This function makes the connection a controller if there is a free role
+  * @note   In the multiplayer arena the connection takes a free player (and
+  *         its snake), otherwise the single controller role.
+  * @param  es: pointer on _state structure
+  * @retval None
+  */
+static void tcp_server_take_control(struct tcp_server_struct *es)
+{
+#if SNAKE_MULTIPLAYER
+  u8_t player;
+  u16_t idx;
+
+  for (player = 0; player < SNAKE_PLAYERS_MAX; player++)
+  {
+    for (idx = 0; idx < SERVER_TCP_MAX_CONN; idx++)
+    {
+      if ((gConnections[idx].state != ES_NONE) && (gConnections[idx].player == player))
+      {
+        break;
+      }
+    }
+
+    if (idx == SERVER_TCP_MAX_CONN)
+    {
+      es->player = player;
+      es->role = ES_ROLE_CONTROLLER;
+      platform_player_attach(player);
+      return;
+    }
+  }
+  es->role = ES_ROLE_SPECTATOR;
+#else
+  es->role = tcp_server_controller() ? ES_ROLE_SPECTATOR : ES_ROLE_CONTROLLER;
+#endif
+}
+
+/**
+  * @brief  This function frees the arena player of a closed connection, its snake leaves the arena
+  * @param  es: pointer on _state structure
+  * @retval None
+  */
+static void tcp_server_release_player(struct tcp_server_struct *es)
+{
+  if (es->player != SERVER_TCP_NO_PLAYER)
+  {
+    platform_player_detach(es->player);
+    es->player = SERVER_TCP_NO_PLAYER;
+  }
+}
+
+/**
+  * @brief  This function restarts the game state stream - call after snake_init
+  * @param  None
+  * @retval None
+  */
+void tcp_server_stream_game_start(void)
+{
+  u16_t idx;
+
+  snake_stream_init(&gStream);
+
+  for (idx = 0; idx < SERVER_TCP_MAX_CONN; idx++)
+  {
+    gConnections[idx].streamKeyframe = 1;
+  }
+}
+
+/**
+  * @brief  This function writes data and records it in the tx FIFO of the connection
+  * @note   All the data of a pooled connection is written here, so the acknowledged
+  *         bytes (tcp_sent) can be matched with the frames referring to stream slots.
+  * @param  tpcb: pointer on the tcp_pcb connection
+  * @param  es: pointer on _state structure
+  * @param  data: data to be sent
+  * @param  len: length of the data
+  * @param  flags: tcp_write flags
+  * @param  slot: stream slot referred by the data, SERVER_TCP_SLOT_NONE if copied
+  * @retval err_t: error code of tcp_write, ERR_MEM also when the FIFO is full
+  */
+static err_t tcp_server_write(struct tcp_pcb *tpcb, struct tcp_server_struct *es, const void *data, u16_t len, u8_t flags, u8_t slot)
+{
+  err_t err;
+  struct tcp_server_tx *tx;
+
+  if (es->txCount >= SERVER_TCP_TX_FIFO)
+  {
+    return ERR_MEM;
+  }
+
+  err = tcp_write(tpcb, data, len, flags);
+  if (err == ERR_OK)
+  {
+    tx = &es->tx[(es->txHead + es->txCount) % SERVER_TCP_TX_FIFO];
+    tx->slot = slot;
+    tx->len = len;
+    es->txCount++;
+
+    if (slot != SERVER_TCP_SLOT_NONE)
+    {
+      gStreamSlots[slot].refs++;
+      es->txSlotRefs++;
+    }
+  }
+  return err;
+}
+
+/**
+  * @brief  This function removes the acknowledged data from the tx FIFO
+  * @param  es: pointer on _state structure
+  * @param  len: number of acknowledged bytes
+  * @retval None
+  */
+static void tcp_server_acked(struct tcp_server_struct *es, u16_t len)
+{
+  struct tcp_server_tx *tx;
+  u16_t rest;
+
+  while ((len > 0) && (es->txCount > 0))
+  {
+    tx = &es->tx[es->txHead];
+    rest = tx->len - es->txAcked;
+
+    if (len < rest)
+    {
+      es->txAcked += len;
+      break;
+    }
+
+    len -= rest;
+    es->txAcked = 0;
+    if (tx->slot != SERVER_TCP_SLOT_NONE)
+    {
+      gStreamSlots[tx->slot].refs--;
+      es->txSlotRefs--;
+    }
+    es->txHead = (es->txHead + 1) % SERVER_TCP_TX_FIFO;
+    es->txCount--;
+  }
+}
+
+/**
+  * @brief  This function drops the tx FIFO (pcb closed or freed), stream slots are released
+  * @param  es: pointer on _state structure
+  * @retval None
+  */
+static void tcp_server_release_tx(struct tcp_server_struct *es)
+{
+  while (es->txCount > 0)
+  {
+    if (es->tx[es->txHead].slot != SERVER_TCP_SLOT_NONE)
+    {
+      gStreamSlots[es->tx[es->txHead].slot].refs--;
+    }
+    es->txHead = (es->txHead + 1) % SERVER_TCP_TX_FIFO;
+    es->txCount--;
+  }
+  es->txAcked = 0;
+  es->txSlotRefs = 0;
+}
+
+/**
+  * @brief  This function sends the game state of the finished tick to the streaming clients
+  * @note   The delta (and a keyframe, when some client needs it) is encoded once into
+  *         a stream slot and the same buffer is enqueued to every client without a copy,
+  *         so adding spectators costs only a tcp_write each. When all the slots are still
+  *         in flight, the tick is sent by copy. A client whose send buffer cannot take the
+  *         frame (slow reader, lost segments) skips it and gets a keyframe as soon as it
+  *         has room again, so the game tick never waits for a client.
+  * @param  snake: pointer to a snake structure
+  * @param  food: pointer to a food structure
+  * @retval None
+  */
+void tcp_server_stream_tick(struct snake_tag *snake, struct food_tag *food)
+{
+  struct tcp_server_struct *es;
+  struct tcp_server_stream_slot *slot;
+  const u8_t *frame;
+  u16_t len;
+  u8_t slotIdx;
+  u8_t flags;
+  u16_t idx;
+
+  /* next slot of the ring, by copy if it is still referenced */
+  slotIdx = (u8_t)((gStreamSlot + 1) % SERVER_TCP_STREAM_SLOTS);
+  if (gStreamSlots[slotIdx].refs == 0)
+  {
+    gStreamSlot = slotIdx;
+    slot = &gStreamSlots[slotIdx];
+    flags = 0;
+  }
+  else
+  {
+    gStreamCopies++;
+    slot = &gStreamCopy;
+    slotIdx = SERVER_TCP_SLOT_NONE;
+    flags = TCP_WRITE_FLAG_COPY;
+  }
+
+  slot->deltaLen = snake_stream_delta(&gStream, snake, food, slot->delta);
+  slot->keyframeLen = 0;
+
+  for (idx = 0; idx < SERVER_TCP_MAX_CONN; idx++)
+  {
+    es = &gConnections[idx];
+
+    if (!es->stream || (es->state != ES_RECEIVED))
+    {
+      continue;
+    }
+
+    if (es->streamKeyframe)
+    {
+      /* encoded only when some client needs it */
+      if (slot->keyframeLen == 0)
+      {
+        slot->keyframeLen = snake_stream_keyframe(&gStream, snake, food, slot->keyframe);
+      }
+      frame = slot->keyframe;
+      len = slot->keyframeLen;
+    }
+    else
+    {
+      frame = slot->delta;
+      len = slot->deltaLen;
+    }
+
+    /* backpressure - the frame is skipped, a keyframe follows */
+    if ((es->journalSize != 0) ||
+        (tcp_sndbuf(es->pcb) < len) ||
+        (tcp_sndqueuelen(es->pcb) + 2 > TCP_SND_QUEUELEN) ||
+        (tcp_server_write(es->pcb, es, frame, len, flags, slotIdx) != ERR_OK))
+    {
+      es->streamSkipped++;
+      es->streamKeyframe = 1;
+      continue;
+    }
+
+    es->streamKeyframe = 0;
+    es->streamFrames++;
+
+    /* called out of the lwIP callbacks - send right away */
+    tcp_output(es->pcb);
+  }
 }
@@ -14,6 +14,64 @@
 #include "tcp.h"
 #include "snake_port.h"
 
+/* Echo of the received bytes (debug) - initial state of each connection,
+ * may be toggled at runtime by SERVER_TCP_CMD_ECHO */
+#ifndef SERVER_TCP_ECHO
+#define SERVER_TCP_ECHO                 0
+#endif
+
+/* Default tuning of the accepted connections, see struct tcp_server_tuning */
+#ifndef SERVER_TCP_PRIO
+#define SERVER_TCP_PRIO                 TCP_PRIO_NORMAL
+#endif
+#ifndef SERVER_TCP_NODELAY
+#define SERVER_TCP_NODELAY              1
+#endif
+#ifndef SERVER_TCP_ACK_NOW
+#define SERVER_TCP_ACK_NOW              1
+#endif
+#ifndef SERVER_TCP_KEEPALIVE_IDLE_MS
+#define SERVER_TCP_KEEPALIVE_IDLE_MS    10000u
+#endif
+#define SERVER_TCP_KEEPALIVE_INTVL_MS   2000u
+#define SERVER_TCP_KEEPALIVE_CNT        3u
+
+/* Size of the connection pool, lwIP needs one more pcb (MEMP_NUM_TCP_PCB)
+ * to refuse an excess connection cleanly */
+#ifndef SERVER_TCP_MAX_CONN
+#define SERVER_TCP_MAX_CONN             4
+#endif
+
+/* Connection which neither sent nor got acknowledged any data for this
+ * time is closed (reaped by the tcp_poll callback) */
+#ifndef SERVER_TCP_IDLE_TIMEOUT_S
+#define SERVER_TCP_IDLE_TIMEOUT_S       60
+#endif
+
+/* Game state frames of the recent ticks shared by the streaming clients */
+#ifndef SERVER_TCP_STREAM_SLOTS
+#define SERVER_TCP_STREAM_SLOTS         4
+#endif
+
+/* Writes of a connection waiting for the acknowledgment */
+#define SERVER_TCP_TX_FIFO              16
+#define SERVER_TCP_SLOT_NONE            0xFF
+
+/* Player of a connection without a snake (SNAKE_MULTIPLAYER) */
+#define SERVER_TCP_NO_PLAYER            0xFF
+
+/* Sent to a refused client before the connection is closed */
+#define SERVER_TCP_REFUSAL              "FULL\r\n"
+
+/* Commands handled by the server itself (not passed to the snake's control) */
+#define SERVER_TCP_CMD_JOURNAL_DUMP		'J'	/* send the game journal to the client */
+#define SERVER_TCP_CMD_JOURNAL_REPLAY	'R'	/* replay the journal from the next game */
+#define SERVER_TCP_CMD_ECHO				'E'	/* toggle the echo of the received bytes */
+#define SERVER_TCP_CMD_STREAM			'V'	/* toggle the game state stream (snake_stream.h) */
+#define SERVER_TCP_CMD_CONTROL			'C'	/* take the controller role (or a player) if it is free */
+#define SERVER_TCP_CMD_NODELAY			'N'	/* toggle Nagle's algorithm of the connection */
+#define SERVER_TCP_CMD_ACK_NOW			'K'	/* toggle the immediate ACK of the received data */
+
 /*  protocol states */
 enum tcp_server_states
 {
@@ -23,15 +81,81 @@ enum tcp_server_states
   ES_CLOSING
 };
 
+/* connection roles - only the controller steers the snake, in the multiplayer
+ * arena each controller steers the snake of its own player */
+enum tcp_server_roles
+{
+  ES_ROLE_SPECTATOR = 0,
+  ES_ROLE_CONTROLLER
+};
+
+/* command parser states (kept across pbufs and segments) */
+enum tcp_server_parse_states
+{
+  PS_DATA = 0,            /* plain command bytes */
+  PS_IAC,                 /* telnet IAC received */
+  PS_IAC_OPTION,          /* telnet WILL/WONT/DO/DONT received, option byte follows */
+  PS_IAC_SB,              /* telnet subnegotiation, up to IAC SE */
+  PS_IAC_SB_IAC,          /* IAC within the subnegotiation */
+  PS_ESC,                 /* ESC received */
+  PS_CSI                  /* ESC [ or ESC O received - cursor keys */
+};
+
+/* per-connection tuning of the control pcb (tcp_server_tune) */
+struct tcp_server_tuning
+{
+  u8_t prio;              /* TCP_PRIO_MIN ~ TCP_PRIO_MAX, lower ones are killed first when lwIP runs out of pcbs */
+  u8_t nodelay;           /* Nagle off - small writes (echo, frames) are sent right away */
+  u8_t ackNow;            /* received data is acknowledged right away instead of the delayed ACK */
+  u32_t keepIdleMs;       /* keepalive - idle time before the first probe, 0 = keepalive off */
+  u32_t keepIntvlMs;      /* keepalive - time between the probes */
+  u32_t keepCnt;          /* keepalive - unanswered probes which drop the connection */
+};
+
+/* write of a connection, acknowledged in the order of the writes */
+struct tcp_server_tx
+{
+  u8_t slot;              /* stream slot referred by the data, SERVER_TCP_SLOT_NONE = copied */
+  u16_t len;
+};
+
 /* structure for maintaing connection infos to be passed as argument
    to LwIP callbacks*/
 struct tcp_server_struct
 {
-  u8_t state;             /* current connection state */
+  u8_t state;             /* current connection state, ES_NONE = free pool slot */
+  u8_t role;              /* tcp_server_roles */
+  u8_t player;            /* arena player of a controller, SERVER_TCP_NO_PLAYER if none */
+  u16_t idlePolls;        /* tcp_poll calls since the last received/acknowledged data */
   struct tcp_pcb *pcb;    /* pointer on the current tcp_pcb */
   struct pbuf *p;         /* pointer on the received/to be transmitted pbuf */
+  u32_t journalOffset;    /* already sent bytes of the journal dump */
+  u32_t journalSize;      /* size of the journal dump in progress, 0 = none */
+  u8_t parseState;        /* tcp_server_parse_states */
+  u8_t echo;              /* received bytes are sent back (debug) */
+  u8_t ackNow;            /* received data is acknowledged right away */
+  u32_t rxBytes;          /* received payload bytes */
+  u32_t commands;         /* bytes and sequences taken as a command */
+  u32_t invalid;          /* bytes which are not a command or not allowed to the role (dropped) */
+  u8_t stream;            /* game state frames are sent to the client */
+  u8_t streamKeyframe;    /* next frame must be a keyframe (joined or skipped) */
+  u32_t streamFrames;     /* sent frames */
+  u32_t streamSkipped;    /* frames skipped for a full send buffer */
+  struct tcp_server_tx tx[SERVER_TCP_TX_FIFO]; /* unacknowledged writes, oldest first */
+  u8_t txHead;
+  u8_t txCount;
+  u16_t txAcked;          /* acknowledged bytes of the oldest write */
+  u8_t txSlotRefs;        /* writes referring to a stream slot */
 };
 
+struct snake_tag;
+struct food_tag;
+
 uint32_t* tcp_server_init(uint16_t port);
+void tcp_server_stream_game_start(void);
+void tcp_server_stream_tick(struct snake_tag *snake, struct food_tag *food);
+struct tcp_server_struct *tcp_server_controller_of(const ip_addr_t *addr);
+void tcp_server_set_tuning(const struct tcp_server_tuning *tuning);
+void tcp_server_tune(struct tcp_server_struct *es, const struct tcp_server_tuning *tuning);
 
 #endif /* SERVER_TCP_H_ */
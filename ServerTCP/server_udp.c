@@ -0,0 +1,202 @@
+/*
+ * server_udp.c
+ *
+ * Control datagrams are handled right in the lwIP receive callback (same
+ * context as the TCP callbacks, so the input queue keeps one producer).
+ */
+
+#include "server_udp.h"
+
+static struct udp_pcb *server_udp_pcb;
+
+/* last accepted seq of a client (address and port) */
+struct server_udp_peer
+{
+  ip_addr_t addr;
+  u16_t port;
+  u16_t seq;
+  u16_t stamp;            /* platform_msTickGet() of the last datagram */
+  u8_t used;
+};
+
+static struct server_udp_peer gPeers[SERVER_UDP_MAX_PEERS];
+static struct server_udp_stats gStats;
+
+static void server_udp_recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16_t port);
+static struct server_udp_peer *server_udp_peer(const ip_addr_t *addr, u16_t port, u16_t now);
+static char server_udp_key(char c);
+
+/**
+  * @brief  Initializes the UDP control channel
+  * @param  port: UDP port to listen on
+  * @retval pointer on the udp_pcb, NULL if it could not be created or bound
+  */
+uint32_t* server_udp_init(uint16_t port)
+{
+  ip4_addr_t ipAddress;
+
+  server_udp_pcb = udp_new();
+
+  if (server_udp_pcb != NULL)
+  {
+    IP4_ADDR(&ipAddress, 192, 168, 100, 1);
+
+    if (udp_bind(server_udp_pcb, &ipAddress, port) == ERR_OK)
+    {
+      udp_recv(server_udp_pcb, server_udp_recv, NULL);
+    }
+    else
+    {
+#ifdef SERVER_TCP_PRINTF_ENABLED
+      printf("Can not bind udp pcb\n");
+#endif
+      udp_remove(server_udp_pcb);
+      server_udp_pcb = NULL;
+    }
+  }
+  return (uint32_t*)server_udp_pcb;
+}
+
+/* Counters of the control channel */
+const struct server_udp_stats* server_udp_stats(void)
+{
+  return &gStats;
+}
+
+/**
+  * @brief  This function is the implementation of the udp_recv LwIP callback
+  * @param  arg: not used
+  * @param  upcb: not used
+  * @param  p: received datagram
+  * @param  addr: sender's address
+  * @param  port: sender's port
+  * @retval None
+  */
+static void server_udp_recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+  struct tcp_server_struct *es;
+  struct server_udp_peer *peer;
+  u8_t datagram[SERVER_UDP_DATAGRAM_LEN];
+  u16_t now = platform_msTickGet();
+  u16_t seq;
+  char key;
+
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(upcb);
+
+  gStats.datagrams++;
+
+  if ((p->tot_len != SERVER_UDP_DATAGRAM_LEN) ||
+      (pbuf_copy_partial(p, datagram, SERVER_UDP_DATAGRAM_LEN, 0) != SERVER_UDP_DATAGRAM_LEN) ||
+      ((key = server_udp_key((char)datagram[2])) == 0))
+  {
+    gStats.invalid++;
+    pbuf_free(p);
+    return;
+  }
+  pbuf_free(p);
+
+  es = tcp_server_controller_of(addr);
+  if (es == NULL)
+  {
+    gStats.refused++;
+    return;
+  }
+
+  seq = (u16_t)(datagram[0] | (datagram[1] << 8));
+  peer = server_udp_peer(addr, port, now);
+
+  /* serial number arithmetic - the seq may wrap around */
+  if (peer->used && (seq == peer->seq))
+  {
+    gStats.duplicate++;
+    return;
+  }
+  if (peer->used && ((s16_t)(seq - peer->seq) < 0))
+  {
+    gStats.stale++;
+    return;
+  }
+
+  peer->used = 1;
+  peer->seq = seq;
+  gStats.accepted++;
+
+  if (es->player != SERVER_TCP_NO_PLAYER)
+  {
+    platform_player_set_control(es->player, key, INPUT_SOURCE_UDP);
+  }
+  else
+  {
+    platform_snake_set_control_from(key, INPUT_SOURCE_UDP);
+  }
+}
+
+/**
+  * @brief  This function finds the seq state of a client, a new client takes
+  *         a free (or the least recently used) entry
+  * @param  addr: client's address
+  * @param  port: client's port
+  * @param  now: platform_msTickGet()
+  * @retval pointer on the peer entry, used == 0 if there is no previous seq
+  */
+static struct server_udp_peer *server_udp_peer(const ip_addr_t *addr, u16_t port, u16_t now)
+{
+  struct server_udp_peer *peer = NULL;
+  struct server_udp_peer *oldest = &gPeers[0];
+  u16_t idx;
+
+  for (idx = 0; idx < SERVER_UDP_MAX_PEERS; idx++)
+  {
+    if ((gPeers[idx].port == port) && ip_addr_cmp(&gPeers[idx].addr, addr))
+    {
+      peer = &gPeers[idx];
+      break;
+    }
+    if ((u16_t)(now - gPeers[idx].stamp) > (u16_t)(now - oldest->stamp))
+    {
+      oldest = &gPeers[idx];
+    }
+  }
+
+  if (peer == NULL)
+  {
+    peer = oldest;
+    ip_addr_copy(peer->addr, *addr);
+    peer->port = port;
+    peer->used = 0;
+  }
+  else if ((u16_t)(now - peer->stamp) > SERVER_UDP_PEER_TIMEOUT_MS)
+  {
+    /* client restarted (or was idle) - its next seq is taken as it is */
+    peer->used = 0;
+  }
+
+  peer->stamp = now;
+  return peer;
+}
+
+/**
+  * @brief  This function checks a control key of a datagram
+  * @param  c: received byte
+  * @retval upper case key, 0 if it is not a direction or pause
+  */
+static char server_udp_key(char c)
+{
+  if ((c >= 'a') && (c <= 'z'))
+  {
+    c = (char)(c - 'a' + 'A');
+  }
+
+  switch (c)
+  {
+  case UP:
+  case DOWN:
+  case LEFT:
+  case RIGHT:
+  case PAUSE:
+    return c;
+  default:
+    return 0;
+  }
+}
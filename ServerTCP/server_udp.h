@@ -0,0 +1,54 @@
+/*
+ * server_udp.h
+ *
+ * Low-latency control channel next to the TCP server. A lost or late
+ * datagram does not hold back the following keys (no head-of-line
+ * blocking, no Nagle or delayed ACK on the client side).
+ *
+ * Control datagram (little endian):
+ *
+ *  offset  size
+ *   0      2     seq      incremented by the client for each new key
+ *   2      1     key      W, A, S, D, P (either case)
+ *
+ * The datagrams are idempotent - a client may send each of them more times
+ * (e.g. twice, against a loss), a seq which is not newer than the last
+ * accepted one of the client is dropped as a duplicate or a stale one.
+ * Only a host holding the controller role over TCP may steer, its keys go
+ * to the same input queue as the TCP ones (counted as INPUT_SOURCE_UDP).
+ */
+
+#ifndef SERVER_UDP_H_
+#define SERVER_UDP_H_
+
+#include "udp.h"
+#include "server_tcp.h"
+
+/* UDP control channel is opened by platform_control_init() */
+#ifndef SERVER_UDP_CONTROL
+#define SERVER_UDP_CONTROL              1
+#endif
+
+/* Clients (address, port) whose last seq is tracked */
+#define SERVER_UDP_MAX_PEERS            4
+
+/* Client which sent nothing for this time starts a new sequence */
+#define SERVER_UDP_PEER_TIMEOUT_MS      5000u
+
+#define SERVER_UDP_DATAGRAM_LEN         3
+
+/* counters of the control channel */
+struct server_udp_stats
+{
+  u32_t datagrams;        /* received datagrams */
+  u32_t accepted;         /* keys passed to the input queue */
+  u32_t duplicate;        /* seq equal to the last accepted one */
+  u32_t stale;            /* seq older than the last accepted one */
+  u32_t invalid;          /* bad length or key */
+  u32_t refused;          /* sender does not hold the controller role */
+};
+
+uint32_t* server_udp_init(uint16_t port);
+const struct server_udp_stats* server_udp_stats(void);
+
+#endif /* SERVER_UDP_H_ */
@@ -0,0 +1,549 @@
+/*
+ * Multiplayer arena for a snake game (snake_functions)
+ *
+ * snake_arena.c
+ *
+ * A tick moves all the snakes at once in phases, each phase is one pass
+ * over the players and one lookup into the occupancy map per player:
+ *
+ *  1. new head cells (border check), the tails leave their cells
+ *  2. a head entering a body (own or other) crashes
+ *  3. the heads enter their cells, a head entering a cell taken by another
+ *     head in this phase crashes both snakes
+ *  4. the crashed snakes leave the arena
+ *
+ * Platform independent - used by the MCU port as well as the host port.
+ */
+
+#include "snake_arena.h"
+#include "snake_function.h"
+
+/* Row where the player's snake is spawned, the rows are spread over the arena */
+#define ARENA_SPAWN_Y(player)	(uint16_t)(ARENA_MIN_Y + ((player) + 1u)*ARENA_MAX_Y/(SNAKE_PLAYERS_MAX + 1u))
+
+#define ARENA_IS_MOVE(dir)		((UP == (dir)) || (DOWN == (dir)) || (LEFT == (dir)) || (RIGHT == (dir)))
+
+
+static inline coord_t* player_body_at(snake_player_t* pl, uint16_t idx)
+{
+	uint16_t pos = pl->tail + idx;
+
+	if (pos >= SNAKE_MAX_LNG)
+	{
+		pos -= SNAKE_MAX_LNG;
+	}
+	return &pl->body[pos];
+}
+
+
+static inline uint8_t player_alive(snake_player_t* pl)
+{
+	return pl->spawned && PLAYING == pl->state;
+}
+
+
+/**
+  * @brief  Mark a cell of the arena as covered by the player's body.
+  *
+  * @note   Cell is also removed from the free cells set (swap with the last one)
+  *
+  * @param arena - pointer to an arena structure
+  * @param cell - coordinations of the cell
+  * @param player - player number
+  * @retval None
+  */
+static inline void arena_occupy_cell(snake_arena_t* arena, coord_t cell, uint8_t player)
+{
+	uint16_t idx = ARENA_CELL_IDX(cell.x, cell.y);
+	uint16_t pos = arena->freeIndex[idx];
+
+	arena->owner[idx] = player + 1;
+
+	if (FREE_CELL_NONE != pos)
+	{
+		uint16_t last = arena->freeCells[--arena->freeCount];
+
+		arena->freeCells[pos] = last;
+		arena->freeIndex[last] = pos;
+		arena->freeIndex[idx] = FREE_CELL_NONE;
+	}
+}
+
+
+/**
+  * @brief  Mark a cell of the arena as free.
+  *
+  * @note   Cell is also appended to the free cells set (if food may be there)
+  *
+  * @param arena - pointer to an arena structure
+  * @param cell - coordinations of the cell
+  * @retval None
+  */
+static inline void arena_release_cell(snake_arena_t* arena, coord_t cell)
+{
+	uint16_t idx = ARENA_CELL_IDX(cell.x, cell.y);
+
+	arena->owner[idx] = ARENA_OWNER_NONE;
+
+	if (food_cell_allowed(cell) && FREE_CELL_NONE == arena->freeIndex[idx])
+	{
+		arena->freeIndex[idx] = arena->freeCount;
+		arena->freeCells[arena->freeCount++] = idx;
+	}
+}
+
+
+/**
+  * @brief  Cell the head enters by a move in the direction
+  *
+  * @param head - current head's cell
+  * @param dir - direction of the move
+  * @param next - entered cell
+  * @retval 0 when the move hits the border
+  */
+static uint8_t arena_next_cell(coord_t head, snake_dir_e dir, coord_t* next)
+{
+	*next = head;
+
+	switch (dir)
+	{
+	case UP:
+		if (head.y == ARENA_MIN_Y) return 0;
+		next->y--;
+		break;
+	case DOWN:
+		if (head.y + 1 == ARENA_MAX_Y) return 0;
+		next->y++;
+		break;
+	case LEFT:
+		if (head.x == ARENA_MIN_X) return 0;
+		next->x--;
+		break;
+	case RIGHT:
+		if (head.x + 1 == ARENA_MAX_X) return 0;
+		next->x++;
+		break;
+	default:
+		break;
+	}
+	return 1;
+}
+
+
+/**
+  * @brief  Spawn the player's snake on its row (paused)
+  *
+  * @param arena - pointer to an arena structure
+  * @param player - player number
+  * @retval 0 when the start cells are not free yet
+  */
+static uint8_t arena_spawn(snake_arena_t* arena, uint8_t player)
+{
+	snake_player_t* pl = &arena->player[player];
+	coord_t cell = { .x = SNAKE_INIT_X_CORD, .y = ARENA_SPAWN_Y(player) };
+
+	for (uint16_t idx = 0; idx < SNAKE_INIT_LNG; idx++, cell.x++)
+	{
+		if (ARENA_OWNER_NONE != arena->owner[ARENA_CELL_IDX(cell.x, cell.y)] ||
+			(PLACED == arena->food.state && cell.x == arena->food.coord.x && cell.y == arena->food.coord.y))
+		{
+			return 0;
+		}
+	}
+
+	pl->direction = PAUSE;
+	pl->state = PLAYING;
+	pl->length = SNAKE_INIT_LNG;
+	pl->tail = 0;
+	pl->head = SNAKE_INIT_LNG - 1;
+	pl->ghost.x = INVALID_COORDS;
+	pl->ghost.y = INVALID_COORDS;
+	pl->moving = 0;
+	pl->entered = 0;
+	pl->spawned = 1;
+
+	for (uint16_t idx = 0; idx < SNAKE_INIT_LNG; idx++)
+	{
+		pl->body[idx].x = SNAKE_INIT_X_CORD + idx;
+		pl->body[idx].y = ARENA_SPAWN_Y(player);
+		arena_occupy_cell(arena, pl->body[idx], player);
+		platform_drawPlayerCell(pl->body[idx].x, pl->body[idx].y, player);
+	}
+
+	return 1;
+}
+
+
+/**
+  * @brief  Remove the player's (crashed) snake from the arena
+  *
+  * @note   The only operation depending on the snake's length, done once
+  *         per crash. The length is kept as the player's score.
+  *
+  *         A snake crashed in phase 2 or 3 has already left its tail cell in
+  *         phase 1 (ghost) without entering the new head cell, its body is
+  *         one cell shorter than its length then. The ring slot after the
+  *         head is stale and must not be released - the cell may already
+  *         belong to another snake.
+  *
+  * @param arena - pointer to an arena structure
+  * @param player - player number
+  * @retval None
+  */
+static void arena_remove(snake_arena_t* arena, uint8_t player)
+{
+	snake_player_t* pl = &arena->player[player];
+	uint16_t cells = pl->length;
+
+	if (INVALID_COORDS != pl->ghost.x && !pl->entered)
+	{
+		cells--;
+	}
+
+	for (uint16_t idx = 0; idx < cells; idx++)
+	{
+		coord_t* cell = player_body_at(pl, idx);
+
+		arena_release_cell(arena, *cell);
+		platform_eraseCell(cell->x, cell->y);
+	}
+
+	/* the tail left its cell in this tick, but it is still drawn */
+	if (INVALID_COORDS != pl->ghost.x && INVALID_COORDS != pl->ghost.y)
+	{
+		platform_eraseCell(pl->ghost.x, pl->ghost.y);
+	}
+
+	pl->ghost.x = INVALID_COORDS;
+	pl->ghost.y = INVALID_COORDS;
+	pl->moving = 0;
+	pl->state = CRASHED;
+}
+
+
+/* Round is over when all the spawned snakes have crashed, or a snake won */
+static void arena_update_state(snake_arena_t* arena)
+{
+	uint8_t spawned = 0;
+	uint8_t alive = 0;
+
+	for (uint8_t player = 0; player < SNAKE_PLAYERS_MAX; player++)
+	{
+		snake_player_t* pl = &arena->player[player];
+
+		spawned += pl->spawned;
+		alive += player_alive(pl);
+
+		if (player_alive(pl) && pl->length >= SNAKE_WON_LIMIT)
+		{
+			pl->state = WON;
+			arena->state = WON;
+		}
+	}
+
+	if (PLAYING == arena->state && spawned && !alive)
+	{
+		arena->state = CRASHED;
+	}
+}
+
+
+/**
+  * @brief  Initialization of a new round
+  *
+  * @note   Players are spawned by snake_arena_control() once attached.
+  *
+  * @param arena - pointer to an arena structure
+  * @retval None
+  */
+void snake_arena_init(snake_arena_t* arena)
+{
+	memset(arena, 0, sizeof(snake_arena_t));
+	memset(&arena->freeIndex[0], 0xFF, ARENA_CELLS*sizeof(uint16_t));
+
+	/* At the beginning all the food cells are free */
+	for (uint16_t y = FOOD_MIN_Y; y <= FOOD_MAX_Y; y++)
+	{
+		for (uint16_t x = FOOD_MIN_X; x <= FOOD_MAX_X; x++)
+		{
+			arena->freeIndex[ARENA_CELL_IDX(x, y)] = arena->freeCount;
+			arena->freeCells[arena->freeCount++] = ARENA_CELL_IDX(x, y);
+		}
+	}
+
+	for (uint8_t player = 0; player < SNAKE_PLAYERS_MAX; player++)
+	{
+		arena->player[player].state = CRASHED;
+	}
+	arena->state = PLAYING;
+
+	platform_refresh_hw();
+	snake_diplay_borders();
+}
+
+
+/**
+  * @brief  Function to join/leave the players and to set the snakes' directions
+  *
+  * @note   An attached player is spawned once per round, a detached
+  *         player's snake leaves the arena (as crashed).
+  *
+  * @param arena - pointer to an arena structure
+  * @retval None
+  */
+void snake_arena_control(snake_arena_t* arena)
+{
+	for (uint8_t player = 0; player < SNAKE_PLAYERS_MAX; player++)
+	{
+		snake_player_t* pl = &arena->player[player];
+
+		if (!platform_player_attached(player))
+		{
+			if (player_alive(pl))
+			{
+				arena_remove(arena, player);
+			}
+			continue;
+		}
+
+		if (!pl->spawned)
+		{
+			(void)arena_spawn(arena, player);
+		}
+		else if (player_alive(pl))
+		{
+			platform_get_player_control(player, &pl->direction);
+		}
+	}
+}
+
+
+/**
+  * @brief  Function to move all the snakes with the crash check, a snake
+  *         whose head enters the food grows.
+  *
+  * @note   Paused snakes do not move (their tails stay). See the phases
+  *         in the header of this file.
+  *
+  * @param arena - pointer to an arena structure
+  * @retval None
+  */
+PLATFORM_FAST_FUNC void snake_arena_move(snake_arena_t* arena)
+{
+	snake_player_t* pl;
+	uint8_t player;
+
+	arena->moved = 0;
+
+	/* 1 - new head cells, the tails leave their cells first */
+	for (player = 0; player < SNAKE_PLAYERS_MAX; player++)
+	{
+		pl = &arena->player[player];
+		pl->moving = 0;
+		pl->entered = 0;
+		pl->ghost.x = INVALID_COORDS;
+		pl->ghost.y = INVALID_COORDS;
+
+		if (!player_alive(pl) || !ARENA_IS_MOVE(pl->direction))
+		{
+			continue;
+		}
+
+		pl->moving = 1;
+		arena->moved = 1;
+
+		if (!arena_next_cell(pl->body[pl->head], pl->direction, &pl->next))
+		{
+			pl->state = CRASHED;
+			continue;
+		}
+
+		pl->grows = (PLACED == arena->food.state) &&
+					(pl->next.x == arena->food.coord.x) && (pl->next.y == arena->food.coord.y);
+
+		/* a growing snake keeps its tail */
+		if (!pl->grows)
+		{
+			pl->ghost = pl->body[pl->tail];
+			arena_release_cell(arena, pl->ghost);
+			pl->tail = SNAKE_RING_NEXT(pl->tail);
+		}
+	}
+
+	/* 2 - no head is in the map yet, an occupied cell is a body */
+	for (player = 0; player < SNAKE_PLAYERS_MAX; player++)
+	{
+		pl = &arena->player[player];
+
+		if (pl->moving && PLAYING == pl->state &&
+			ARENA_OWNER_NONE != arena->owner[ARENA_CELL_IDX(pl->next.x, pl->next.y)])
+		{
+			pl->state = CRASHED;
+		}
+	}
+
+	/* 3 - heads enter their cells, a cell taken in this phase is a head-to-head */
+	for (player = 0; player < SNAKE_PLAYERS_MAX; player++)
+	{
+		uint8_t other;
+
+		pl = &arena->player[player];
+
+		if (!pl->moving || PLAYING != pl->state)
+		{
+			continue;
+		}
+
+		other = arena->owner[ARENA_CELL_IDX(pl->next.x, pl->next.y)];
+		if (ARENA_OWNER_NONE != other)
+		{
+			pl->state = CRASHED;
+			arena->player[other - 1].state = CRASHED;
+			continue;
+		}
+
+		pl->head = SNAKE_RING_NEXT(pl->head);
+		pl->body[pl->head] = pl->next;
+		pl->entered = 1;
+		arena_occupy_cell(arena, pl->next, player);
+
+		if (pl->grows)
+		{
+			pl->length++;
+			arena->food.state = EATEN;
+		}
+	}
+
+	/* 4 - crashed snakes leave the arena, the others play on */
+	for (player = 0; player < SNAKE_PLAYERS_MAX; player++)
+	{
+		pl = &arena->player[player];
+
+		if (pl->moving && PLAYING != pl->state)
+		{
+			arena_remove(arena, player);
+		}
+	}
+
+	arena_update_state(arena);
+}
+
+
+/**
+  * @brief  Display the moves of the tick
+  *
+  * @note   All the tails are erased before the heads are drawn, a head
+  *         may enter the cell just left by a tail. An erased tail is no
+  *         longer the snake's ghost.
+  *
+  * @param arena - pointer to an arena structure
+  * @retval None
+  */
+void snake_arena_display(snake_arena_t* arena)
+{
+	snake_player_t* pl;
+	uint8_t player;
+
+	for (player = 0; player < SNAKE_PLAYERS_MAX; player++)
+	{
+		pl = &arena->player[player];
+
+		if (pl->moving && INVALID_COORDS != pl->ghost.x && INVALID_COORDS != pl->ghost.y)
+		{
+			platform_eraseCell(pl->ghost.x, pl->ghost.y);
+		}
+
+		/* the cell may get the food or another head before the next tick */
+		pl->ghost.x = INVALID_COORDS;
+		pl->ghost.y = INVALID_COORDS;
+	}
+
+	for (player = 0; player < SNAKE_PLAYERS_MAX; player++)
+	{
+		pl = &arena->player[player];
+
+		if (pl->moving)
+		{
+			platform_drawPlayerCell(pl->body[pl->head].x, pl->body[pl->head].y, player);
+		}
+	}
+}
+
+
+/**
+  * @brief  Function to place a new food in the arena
+  *
+  * @note   Same timing as snake_place_food() - each 10th tick with a move,
+  *         the food is drawn from the free cells set of all the snakes.
+  *
+  * @param arena - pointer to an arena structure
+  * @retval None
+  */
+void snake_arena_place_food(snake_arena_t* arena)
+{
+	food_t* food = &arena->food;
+
+	if (!arena->moved)
+	{
+		return;
+	}
+
+	if (0 == arena->cycle % 10 || food->time_elapsed)
+	{
+		if (food->state != PLACED)
+		{
+			if (0 == arena->freeCount)
+			{
+				platform_fatal();
+			}
+			else
+			{
+				uint16_t cell = arena->freeCells[platform_randomize() % arena->freeCount];
+
+				food->coord.x = cell % ARENA_MAX_X;
+				food->coord.y = cell / ARENA_MAX_X;
+				platform_drawFood(food->coord.x, food->coord.y);
+
+				food->time_elapsed = 0;
+				food->state = PLACED;
+			}
+		}
+		else
+		{
+			food->time_elapsed = 1;
+		}
+	}
+	arena->cycle++;
+}
+
+
+/**
+  * @brief  Function to print the result of the round
+  *
+  * @param arena - pointer to an arena structure
+  * @retval None
+  */
+void snake_arena_inform(snake_arena_t* arena)
+{
+	char printStr[20] = {0};
+	uint16_t best = 0;
+	uint8_t bestPlayer = 0;
+
+	if (PLAYING == arena->state)
+	{
+		return;
+	}
+
+	for (uint8_t player = 0; player < SNAKE_PLAYERS_MAX; player++)
+	{
+		if (arena->player[player].spawned && arena->player[player].length > best)
+		{
+			best = arena->player[player].length;
+			bestPlayer = player;
+		}
+	}
+
+	sprintf(printStr, " %s:P%u:%05d", (WON == arena->state) ? "Win  !" : "Over !",
+			(unsigned)(bestPlayer + 1), best - SNAKE_INIT_LNG);
+	platform_print_text(printStr, strlen(printStr), WHITE);
+}
@@ -0,0 +1,72 @@
+/*
+ * Multiplayer arena for a snake game (snake_functions)
+ *
+ * snake_arena.h
+ *
+ * Up to SNAKE_PLAYERS_MAX snakes in one arena, each steered through its own
+ * input queue (platform_player_set_control), sharing one food. The arena
+ * keeps one occupancy map for all the snakes - a cell holds the number of
+ * the player whose body covers it - so a move is checked by a single lookup
+ * of the new head's cell, whatever the number and the length of the snakes.
+ *
+ * Rules of a round:
+ *  - an attached player is spawned (paused) on its own row as soon as the
+ *    row's start cells are free, the pause key starts the snake
+ *  - the tails leave their cells before the heads enter, a head may follow
+ *    a tail (of any snake) closely
+ *  - a head hitting the border or any body crashes the snake, two heads
+ *    entering the same cell crash both snakes
+ *  - a crashed (or detached) snake leaves the arena, the others play on
+ *  - the round is over when all the spawned snakes have crashed, or won
+ *    when a snake reaches SNAKE_WON_LIMIT
+ *
+ * Usage (see VS_SnakeArenaLoop in main.c): snake_arena_init() once per
+ * round, then each tick snake_arena_control(), snake_arena_move(),
+ * snake_arena_inform(), snake_arena_display(), snake_arena_place_food().
+ */
+
+#ifndef SNAKE_ARENA_H_
+#define SNAKE_ARENA_H_
+
+#include "snake_port.h"
+
+/* Owner of a free cell within snake_arena_t.owner */
+#define ARENA_OWNER_NONE		(uint8_t)(0)
+
+typedef struct snake_player_tag
+{
+	snake_dir_e direction;
+	coord_t body[SNAKE_MAX_LNG];	/* ring buffer, body[tail] ~ body[head] */
+	uint16_t head;
+	uint16_t tail;
+	uint16_t length;				/* kept after a crash (score) */
+	coord_t ghost;					/* tail cell left this tick, INVALID_COORDS if none or erased */
+	coord_t next;					/* cell entered by the head this tick */
+	snake_state_e state;
+	uint8_t spawned;				/* took part in the round (also after a crash) */
+	uint8_t moving;					/* moves this tick */
+	uint8_t grows;					/* the head enters the food cell this tick */
+	uint8_t entered;				/* the head entered its cell this tick (phase 3) */
+} snake_player_t;
+
+typedef struct snake_arena_tag
+{
+	snake_player_t player[SNAKE_PLAYERS_MAX];
+	uint8_t owner[ARENA_CELLS];			/* player + 1 whose body covers the cell */
+	uint16_t freeCells[FOOD_CELLS];		/* food cells not covered by any body (dense) */
+	uint16_t freeIndex[ARENA_CELLS];	/* position of a cell within freeCells */
+	uint16_t freeCount;
+	food_t food;
+	snake_state_e state;		/* PLAYING until the round is over */
+	uint8_t moved;				/* any snake moved this tick */
+	uint32_t cycle;				/* ticks with a move (to know, when to place a food) */
+} snake_arena_t;
+
+void snake_arena_init(snake_arena_t* arena);
+void snake_arena_control(snake_arena_t* arena);
+void snake_arena_move(snake_arena_t* arena);
+void snake_arena_display(snake_arena_t* arena);
+void snake_arena_place_food(snake_arena_t* arena);
+void snake_arena_inform(snake_arena_t* arena);
+
+#endif /* SNAKE_ARENA_H_ */
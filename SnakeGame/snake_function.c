@@ -70,8 +70,70 @@
 
 #include "snake_function.h"
 
-/* Counter incremented each game cycle (to know, when to generate a snake's food) */
-static uint32_t gPrgCycle = 0;
+/**
+  * @brief  Mark a cell of the arena as occupied by the snake's body.
+  *
+  * @note   Cell is also removed from the free cells set (swap with the last one)
+  *
+  * @param snake - pointer to a snake structure
+  * @param cell - coordinations of the cell
+  * @retval None
+  */
+static inline void snake_occupy_cell(snake_t* snake, coord_t cell)
+{
+	uint16_t idx = ARENA_CELL_IDX(cell.x, cell.y);
+	uint16_t pos = snake->freeIndex[idx];
+
+	snake->occupancy[idx >> 5] |= (uint32_t)1 << (idx & 31);
+
+	if (FREE_CELL_NONE != pos)
+	{
+		uint16_t last = snake->freeCells[--snake->freeCount];
+
+		snake->freeCells[pos] = last;
+		snake->freeIndex[last] = pos;
+		snake->freeIndex[idx] = FREE_CELL_NONE;
+	}
+}
+
+/**
+  * @brief  Mark a cell of the arena as free (no more part of the body).
+  *
+  * @note   Cell is also appended to the free cells set (if food may be there)
+  *
+  * @param snake - pointer to a snake structure
+  * @param cell - coordinations of the cell
+  * @retval None
+  */
+static inline void snake_release_cell(snake_t* snake, coord_t cell)
+{
+	uint16_t idx = ARENA_CELL_IDX(cell.x, cell.y);
+
+	snake->occupancy[idx >> 5] &= ~((uint32_t)1 << (idx & 31));
+
+	if (food_cell_allowed(cell) && FREE_CELL_NONE == snake->freeIndex[idx])
+	{
+		snake->freeIndex[idx] = snake->freeCount;
+		snake->freeCells[snake->freeCount++] = idx;
+	}
+}
+
+/**
+  * @brief  Check whether a cell is occupied by the snake's body.
+  *
+  * @note   Single bit test replacing the former scan of the whole body,
+  *         so the cost does not depend on the snake's length.
+  *
+  * @param snake - pointer to a snake structure
+  * @param x - coordination limited by ARENA_MAX_X.
+  * @param y - coordination limited by ARENA_MAX_Y.
+  * @retval non-zero if the cell is occupied
+  */
+static inline uint32_t snake_is_occupied(snake_t* snake, uint16_t x, uint16_t y)
+{
+	uint16_t idx = ARENA_CELL_IDX(x, y);
+	return snake->occupancy[idx >> 5] & ((uint32_t)1 << (idx & 31));
+}
 
 /**
   * @brief  Function to set snake's direction.
@@ -120,13 +182,30 @@ void snake_init(snake_t* snake)
 	snake->ghost.y = INVALID_COORDS;
 	snake->printWholeSnake = 1;
 	memset(&snake->body[0], 0, SNAKE_MAX_LNG*sizeof(coord_t));
+	memset(&snake->occupancy[0], 0, ARENA_OCC_WORDS*sizeof(uint32_t));
+	memset(&snake->freeIndex[0], 0xFF, ARENA_CELLS*sizeof(uint16_t));
+
+	/* At the beginning all the food cells are free */
+	snake->freeCount = 0;
+	for (uint16_t y = FOOD_MIN_Y; y <= FOOD_MAX_Y; y++)
+	{
+		for (uint16_t x = FOOD_MIN_X; x <= FOOD_MAX_X; x++)
+		{
+			snake->freeIndex[ARENA_CELL_IDX(x, y)] = snake->freeCount;
+			snake->freeCells[snake->freeCount++] = ARENA_CELL_IDX(x, y);
+		}
+	}
 
-	gPrgCycle = 0;
+	snake->cycle = 0;
+
+	snake->tail = 0;
+	snake->head = SNAKE_INIT_LNG - 1;
 
 	for (int idx = 0; idx < SNAKE_INIT_LNG; idx++)
 	{
 		snake->body[idx].x = SNAKE_INIT_X_CORD + idx;
 		snake->body[idx].y = SNAKE_INIT_Y_CORD;
+		snake_occupy_cell(snake, snake->body[idx]);
 	}
 
 	platform_refresh_hw();
@@ -134,6 +213,51 @@ void snake_init(snake_t* snake)
 
 }
 
+/**
+  * @brief  Restore the body of a snake (e.g. from a journal checkpoint)
+  *
+  * @note   Called after snake_init(). The occupancy bitmap is rebuilt from
+  *         the body and the free cells set is taken over in the given order,
+  *         so the following food draws match the original game. The whole
+  *         snake is drawn by the next snake_display().
+  *
+  * @param snake - pointer to a snake structure
+  * @param body - cells of the body from the tail to the head
+  * @param length - number of the body cells, <= SNAKE_MAX_LNG
+  * @param freeCells - free cells set (ARENA_CELL_IDX) in the original order
+  * @param freeCount - number of the free cells, <= FOOD_CELLS
+  * @retval None
+  */
+void snake_restore(snake_t* snake, const coord_t* body, uint16_t length,
+				   const uint16_t* freeCells, uint16_t freeCount)
+{
+	memset(&snake->occupancy[0], 0, ARENA_OCC_WORDS*sizeof(uint32_t));
+	memset(&snake->freeIndex[0], 0xFF, ARENA_CELLS*sizeof(uint16_t));
+
+	snake->length = length;
+	snake->tail = 0;
+	snake->head = length - 1;
+
+	for (uint16_t idx = 0; idx < length; idx++)
+	{
+		uint16_t cell = ARENA_CELL_IDX(body[idx].x, body[idx].y);
+
+		snake->body[idx] = body[idx];
+		snake->occupancy[cell >> 5] |= (uint32_t)1 << (cell & 31);
+	}
+
+	snake->freeCount = freeCount;
+	for (uint16_t pos = 0; pos < freeCount; pos++)
+	{
+		snake->freeCells[pos] = freeCells[pos];
+		snake->freeIndex[freeCells[pos]] = pos;
+	}
+
+	snake->ghost.x = INVALID_COORDS;
+	snake->ghost.y = INVALID_COORDS;
+	snake->printWholeSnake = 1;
+}
+
 /**
   * @brief  Display/Draw a snake
   *
@@ -161,13 +285,14 @@ void snake_display(snake_t*  snake)
 		snake ->printWholeSnake = 0;
 		for (int idx = 0; idx < snake->length; idx++)
 		{
-			platform_drawCell(snake->body[idx].x, snake->body[idx].y);
+			coord_t* cell = snake_body_at(snake, idx);
+			platform_drawCell(cell->x, cell->y);
 		}
 	}
 	else
 	{
 		/* In case of move, draw snake's new head */
-		platform_drawCell(snake->body[snake->length - 1].x, snake->body[snake->length - 1].y);
+		platform_drawCell(snake_head(snake)->x, snake_head(snake)->y);
 	}
 
 }
@@ -194,96 +319,87 @@ void snake_diplay_borders(void)
   * @param snake - pointer to a snake structure
   * @retval None
   */
-void snake_move(snake_t* snake)
+PLATFORM_FAST_FUNC void snake_move(snake_t* snake)
 {
+	coord_t* head;
+
 	if (NULL == snake || PAUSE == snake->direction)
 	{
 		return;
 	}
 
-	/* Prepare a 'ghost tail' to be erased on display */
-	snake->ghost = snake->body[0];
-
-	/* shift the whole array right, override tail (unneeded ghost tail) and make room for a new head*/
-	memcpy(&snake->body[0], &snake->body[1], sizeof(coord_t) * (snake->length - 1));
+	/* Prepare a 'ghost tail' to be erased on display, its cell is free from now */
+	snake->ghost = *snake_tail(snake);
+	snake_release_cell(snake, snake->ghost);
 
+	/* drop the tail (unneeded ghost tail) and make room for a new head - only
+	 * the ring indexes move, the new head starts as a copy of the old one */
+	head = snake_head(snake);
+	snake->tail = SNAKE_RING_NEXT(snake->tail);
+	snake->head = SNAKE_RING_NEXT(snake->head);
+	*snake_head(snake) = *head;
+	head = snake_head(snake);
 
 	/* According to the direction check whether snake did not hit arena borders,
-	 * then in the for loop check whether snake did not bit itself and finally
-	 * do a head's coordinations adjustment => head is snake->body[snake->length - 1] */
+	 * then check in the occupancy bitmap whether snake did not bit itself and finally
+	 * do a head's coordinations adjustment => head is snake->body[snake->head] */
 	switch (snake->direction)
 	{
 	case UP:
 	{
-		if ((snake->body[snake->length - 1].y - 1) == ARENA_MIN_Y - 1) // because 0 is still valid
+		if ((head->y - 1) == ARENA_MIN_Y - 1) // because 0 is still valid
 		{
 			snake->state = CRASHED;
 			break;
 		}
-		for (int idx = 0; idx < snake->length; idx++)
+		if (snake_is_occupied(snake, head->x, head->y - 1))
 		{
-			if (((snake->body[snake->length - 1].y - 1) == snake->body[idx].y) &&
-				((snake->body[snake->length - 1].x) == snake->body[idx].x))
-			{
-				snake->state = CRASHED;
-			}
+			snake->state = CRASHED;
 		}
-		snake->body[snake->length - 1].y--;
+		head->y--;
 	}
 	break;
 	case DOWN:
 	{
-		if ((snake->body[snake->length - 1].y + 1) == ARENA_MAX_Y)
+		if ((head->y + 1) == ARENA_MAX_Y)
 		{
 			snake->state = CRASHED;
 			break;
 		}
-		for (int idx = 0; idx < snake->length; idx++)
+		if (snake_is_occupied(snake, head->x, head->y + 1))
 		{
-			if (((snake->body[snake->length - 1].y + 1) == snake->body[idx].y) &&
-				((snake->body[snake->length - 1].x) == snake->body[idx].x))
-			{
-				snake->state = CRASHED;
-			}
+			snake->state = CRASHED;
 		}
 
-		snake->body[snake->length - 1].y++;
+		head->y++;
 	}
 	break;
 	case RIGHT:
 	{
-		if ((snake->body[snake->length - 1].x + 1) == ARENA_MAX_X)
+		if ((head->x + 1) == ARENA_MAX_X)
 		{
 			snake->state = CRASHED;
 			break;
 		}
-		for (int idx = 0; idx < snake->length; idx++)
+		if (snake_is_occupied(snake, head->x + 1, head->y))
 		{
-			if (((snake->body[snake->length - 1].x + 1) == snake->body[idx].x) &&
-				((snake->body[snake->length - 1].y) == snake->body[idx].y))
-			{
-				snake->state = CRASHED;
-			}
+			snake->state = CRASHED;
 		}
-		snake->body[snake->length - 1].x++;
+		head->x++;
 	}
 	break;
 	case LEFT:
 	{
-		if ((snake->body[snake->length - 1].x - 1) == ARENA_MIN_X - 1) // because 0 is still valid
+		if ((head->x - 1) == ARENA_MIN_X - 1) // because 0 is still valid
 		{
 			snake->state = CRASHED;
 			break;
 		}
-		for (int idx = 0; idx < snake->length; idx++)
+		if (snake_is_occupied(snake, head->x - 1, head->y))
 		{
-			if (((snake->body[snake->length - 1].x - 1) == snake->body[idx].x) &&
-				((snake->body[snake->length - 1].y) == snake->body[idx].y))
-			{
-				snake->state = CRASHED;
-			}
+			snake->state = CRASHED;
 		}
-		snake->body[snake->length - 1].x--;
+		head->x--;
 	}
 	break;
 	default:
@@ -291,6 +407,9 @@ void snake_move(snake_t* snake)
 	}
 	}
 
+	/* New head (or the unchanged one after a border hit) is part of the body */
+	snake_occupy_cell(snake, *head);
+
 	if (snake->length == SNAKE_WON_LIMIT)
 	{
 		snake->state = WON;
@@ -300,60 +419,38 @@ void snake_move(snake_t* snake)
 /**
   * @brief  Function to generate a valid foord coordination and place it
   *
-  * @note   Food is generated by a algorithm to prevent food's placement on the snake
-  *         or behind the allowed borders. Finally, the food is drawn on the display.
+  * @note   Food is placed into a cell randomly drawn from the free cells set,
+  *         which is kept in sync with the snake's body. Therefore the food can
+  *         not be placed on the snake or behind the allowed borders and only
+  *         one random draw is needed (no retries, no randomizer re-seeding).
+  *         Finally, the food is drawn on the display.
   *
   * @param snake - pointer to a snake structure
   * @param snake - pointer to a food structure
   *
-  * @retval None
+  * @retval 0 when placed, GENERAL_ERROR when there is no free cell
   */
-uint16_t static generate_food(snake_t* snake, food_t *food)
+static uint16_t generate_food(snake_t* snake, food_t *food)
 {
-	uint16_t isInvalid = 0;
-	uint16_t iter = 0;
-	coord_t coords;
+	uint16_t cell;
 
 	if (NULL == snake || NULL == food || PAUSE == snake->direction)
 	{
 		return -1;
 	}
 
-	/* Try to generate x and y coords of the food and check if it is not snake's body */
-	do
+	if (0 == snake->freeCount)
 	{
-		isInvalid = 0;
-		coords.x = (uint16_t)((platform_randomize() % (FOOD_MAX_X - FOOD_MIN_X + 1)) + FOOD_MIN_X);
-		coords.y = (uint16_t)((platform_randomize() % (FOOD_MAX_Y - FOOD_MIN_Y + 1)) + FOOD_MIN_Y);
-
-		/* Check validity - can't be part of the snake's body */
-		for (int idx = 0; idx < snake->length; idx++)
-		{
-			if(0 == memcmp(&(snake->body[idx]), &coords, sizeof(coord_t)))
-			{
-				isInvalid = GENERAL_ERROR;
-				break;
-			}
-		}
-
-		iter++;
-
-		/* If iteration went too many times through re-initialize randomizer */
-		if (iter > FOOD_MAX_ITER)
-		{
-			platform_init_randomizer();
-		}
+		return GENERAL_ERROR;
+	}
 
-	} while (isInvalid);
+	cell = snake->freeCells[platform_randomize() % snake->freeCount];
 
-	if (!isInvalid)
-	{
-		food->coord.x = coords.x;
-		food->coord.y = coords.y;
-		platform_drawFood(food->coord.x, food->coord.y);
-	}
+	food->coord.x = cell % ARENA_MAX_X;
+	food->coord.y = cell / ARENA_MAX_X;
+	platform_drawFood(food->coord.x, food->coord.y);
 
-	return isInvalid;
+	return 0;
 
 }
 
@@ -361,7 +458,7 @@ uint16_t static generate_food(snake_t* snake, food_t *food)
   * @brief  Function to place a new food in the arena
   *
   * @note   Function utilizes generate_food() when is "the time" to generate food.
-  *         This means that gPrgCycle % 10 must be reached and also food must be
+  *         This means that snake->cycle % 10 must be reached and also food must be
   *         already eaten. If there is a not eaten food and time still elapsed, just
   *         a flag time_elapsed is raised to indicate for next call, that food shall
   *         be immediately placed.
@@ -385,7 +482,7 @@ void snake_place_food(snake_t* snake, food_t* food)
 		return;
 	}
 
-	if (0 == gPrgCycle % 10 || food->time_elapsed)
+	if (0 == snake->cycle % 10 || food->time_elapsed)
 	{
 		if (food->state != PLACED)
 		{
@@ -405,7 +502,7 @@ void snake_place_food(snake_t* snake, food_t* food)
 		}
 
 	}
-	gPrgCycle++;
+	snake->cycle++;
 
 }
 
@@ -428,16 +525,13 @@ void snake_haseaten(snake_t* snake, food_t* food)
 		return;
 	}
 
-	if ((snake->body[snake->length - 1].x == food->coord.x)
-		&& (snake->body[snake->length - 1].y == food->coord.y))
+	if ((snake_head(snake)->x == food->coord.x)
+		&& (snake_head(snake)->y == food->coord.y))
 	{
-		/* Needed temporary copy for shifting the whole array into right - for an MCU embedded*/
-		coord_t tempSnake[SNAKE_MAX_LNG] = {0};
-		memcpy(tempSnake, &(snake->body[0]), (size_t)snake->length*sizeof(coord_t));
-
-		/* Just append the ghost to the end, increment length and disable ghost erase this cycle*/
-		memcpy(&(snake->body[1]), tempSnake, (size_t)snake->length*sizeof(coord_t));
-		snake->body[0] = snake->ghost;
+		/* Just append the ghost in front of the tail, increment length and disable ghost erase this cycle*/
+		snake->tail = SNAKE_RING_PREV(snake->tail);
+		*snake_tail(snake) = snake->ghost;
+		snake_occupy_cell(snake, snake->ghost);
 		snake->ghost.x = INVALID_COORDS;
 		snake->ghost.y = INVALID_COORDS;
 		snake->length++;
@@ -509,9 +603,9 @@ void snake_delay(uint32_t Delay, fn_t func)
   uint32_t dummyArgRet = 0;
 
   /* Add a freq to guarantee minimum wait */
-  if (wait < HAL_MAX_DELAY)
+  if (wait < PLATFORM_MAX_DELAY)
   {
-    wait += (uint32_t)(uwTickFreq);
+    wait += (uint32_t)(PLATFORM_TICK_FREQ);
   }
 
   while ((platform_msTickGet() - tickstart) < wait)
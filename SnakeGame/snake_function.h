@@ -15,8 +15,52 @@
  * used for snake_delay as an function called during blocking delay */
 typedef uint32_t fn_t(uint32_t);
 
+/* Index of the cell x, y within the arena (occupancy bitmap, free cells set) */
+#define ARENA_CELL_IDX(x, y)	((uint16_t)((y)*ARENA_MAX_X + (x)))
+
+/* Mark of a cell which is not in the free cells set */
+#define FREE_CELL_NONE			(uint16_t)(-1)
+
+/* Next/previous index within the snake's body ring buffer */
+#define SNAKE_RING_NEXT(idx)	((uint16_t)(((idx) + 1 == SNAKE_MAX_LNG) ? 0 : (idx) + 1))
+#define SNAKE_RING_PREV(idx)	((uint16_t)((0 == (idx)) ? SNAKE_MAX_LNG - 1 : (idx) - 1))
+
+/* The snake's body is a ring buffer - body[tail] is the tail and body[head] is
+ * the head. Moving or growing the snake only adjusts head/tail, the body is never
+ * copied. Index 'idx' of snake_body_at() counts from the tail (0) to the head
+ * (length - 1), the same order as the former flat array had. */
+static inline coord_t* snake_body_at(snake_t* snake, uint16_t idx)
+{
+	uint16_t pos = snake->tail + idx;
+
+	if (pos >= SNAKE_MAX_LNG)
+	{
+		pos -= SNAKE_MAX_LNG;
+	}
+	return &snake->body[pos];
+}
+
+static inline coord_t* snake_head(snake_t* snake)
+{
+	return &snake->body[snake->head];
+}
+
+static inline coord_t* snake_tail(snake_t* snake)
+{
+	return &snake->body[snake->tail];
+}
+
+/* Food may be placed only into cells of the FOOD_MIN/MAX range */
+static inline uint8_t food_cell_allowed(coord_t cell)
+{
+	return (cell.x >= FOOD_MIN_X) && (cell.x <= FOOD_MAX_X) &&
+		   (cell.y >= FOOD_MIN_Y) && (cell.y <= FOOD_MAX_Y);
+}
+
 void snake_hw_init(void);
 void snake_init(snake_t* snake);
+void snake_restore(snake_t* snake, const coord_t* body, uint16_t length,
+				   const uint16_t* freeCells, uint16_t freeCount);
 void snake_display(snake_t* snake);
 void snake_diplay_borders(void);
 void snake_move(snake_t* snake);
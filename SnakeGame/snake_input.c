@@ -0,0 +1,145 @@
+/*
+ * Input queue for a snake game (snake_functions)
+ *
+ * snake_input.c
+ *
+ * Indexes run freely (uint16_t) and are masked by SNAKE_INPUT_LEN - 1, so
+ * head - tail is the number of queued keys even after the wrap-around.
+ * The release store of an index publishes the slot written before it.
+ *
+ * Platform independent - used by the MCU port as well as the host port.
+ */
+
+#include <string.h>
+
+#include "snake_input.h"
+
+#define SNAKE_INPUT_MASK	(uint16_t)(SNAKE_INPUT_LEN - 1u)
+
+
+/* Histogram bin of a latency - bit length of the value, saturated */
+static inline uint16_t snake_input_hist_bin(uint16_t latency)
+{
+	uint16_t bin = 0;
+
+	while (latency && bin < SNAKE_INPUT_HIST_BINS - 1u)
+	{
+		latency >>= 1;
+		bin++;
+	}
+	return bin;
+}
+
+
+/**
+  * @brief  Initialize an (empty) input queue
+  *
+  * @note   Must not be called while the producer may push.
+  *
+  * @param input - pointer to an input queue
+  * @param policy - how the keys are popped, see snake_input_policy_e
+  * @retval None
+  */
+void snake_input_init(snake_input_t* input, snake_input_policy_e policy)
+{
+	memset(input, 0, sizeof(snake_input_t));
+	atomic_init(&input->head, 0);
+	atomic_init(&input->tail, 0);
+	input->policy = policy;
+	input->maxAgeMs = SNAKE_INPUT_MAX_AGE_MS;
+}
+
+
+/**
+  * @brief  Queue a key - producer side (callback or ISR)
+  *
+  * @param input - pointer to an input queue
+  * @param key - received key
+  * @param stamp - platform_msTickGet() of the reception
+  * @param source - path the key came by (latency histogram)
+  * @retval 1 queued, 0 dropped (queue full)
+  */
+uint8_t snake_input_push(snake_input_t* input, char key, uint16_t stamp, snake_input_source_e source)
+{
+	uint16_t head = (uint16_t)atomic_load_explicit(&input->head, memory_order_relaxed);
+	uint16_t tail = (uint16_t)atomic_load_explicit(&input->tail, memory_order_acquire);
+
+	if ((uint16_t)(head - tail) >= SNAKE_INPUT_LEN)
+	{
+		input->dropped++;
+		return 0;
+	}
+
+	input->cmd[head & SNAKE_INPUT_MASK].key = key;
+	input->cmd[head & SNAKE_INPUT_MASK].stamp = stamp;
+	input->cmd[head & SNAKE_INPUT_MASK].source = (uint8_t)source;
+	atomic_store_explicit(&input->head, (uint16_t)(head + 1u), memory_order_release);
+	input->pushed++;
+
+	return 1;
+}
+
+
+/**
+  * @brief  Key for the current tick - consumer side (platform_get_control)
+  *
+  * @note   Stale keys are skipped. INPUT_POLICY_ONE_PER_TICK returns the
+  *         oldest queued key, INPUT_POLICY_LATEST empties the queue and
+  *         returns the newest one.
+  *
+  * @param input - pointer to an input queue
+  * @param now - platform_msTickGet() of the tick
+  * @retval key, 0 = none
+  */
+char snake_input_pop(snake_input_t* input, uint16_t now)
+{
+	uint16_t tail = (uint16_t)atomic_load_explicit(&input->tail, memory_order_relaxed);
+	uint16_t head = (uint16_t)atomic_load_explicit(&input->head, memory_order_acquire);
+	snake_input_cmd_t cmd = { 0 };
+	uint8_t found = 0;
+
+	while (tail != head)
+	{
+		snake_input_cmd_t next = input->cmd[tail & SNAKE_INPUT_MASK];
+		uint16_t age = (uint16_t)(now - next.stamp);
+
+		tail++;
+
+		if (input->maxAgeMs && age > input->maxAgeMs)
+		{
+			input->stale++;
+			continue;
+		}
+
+		if (found)
+		{
+			input->coalesced++;
+		}
+		cmd = next;
+		found = 1;
+
+		if (INPUT_POLICY_ONE_PER_TICK == input->policy)
+		{
+			break;
+		}
+	}
+
+	atomic_store_explicit(&input->tail, tail, memory_order_release);
+
+	if (!found)
+	{
+		return 0;
+	}
+
+	input->applied++;
+	if ((uint16_t)(now - cmd.stamp) > input->latencyMax)
+	{
+		input->latencyMax = (uint16_t)(now - cmd.stamp);
+	}
+	if (cmd.source < INPUT_SOURCES)
+	{
+		input->latencyHist[cmd.source][snake_input_hist_bin((uint16_t)(now - cmd.stamp))]++;
+	}
+
+	return cmd.key;
+}
@@ -0,0 +1,92 @@
+/*
+ * Input queue for a snake game (snake_functions)
+ *
+ * snake_input.h
+ *
+ * Bounded single-producer/single-consumer ring of timestamped keys. The
+ * producer (TCP receive callback, UART ISR, ...) pushes the keys as they
+ * come, the consumer (platform_get_control() once per tick) pops them
+ * according to the policy, so keys which arrive between two ticks are no
+ * more overwritten by each other.
+ *
+ * Lock-free: the producer writes only 'head' and the producer counters,
+ * the consumer only 'tail' and the consumer counters. There must be only
+ * one producer per queue - two of them (e.g. TCP and UART) need a queue
+ * each or a critical section around snake_input_push().
+ */
+
+#ifndef SNAKE_INPUT_H_
+#define SNAKE_INPUT_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+/* Number of queued keys, power of 2 */
+#ifndef SNAKE_INPUT_LEN
+#define SNAKE_INPUT_LEN				(16u)
+#endif
+
+/* Keys queued longer than this are dropped as stale (0 = never) */
+#ifndef SNAKE_INPUT_MAX_AGE_MS
+#define SNAKE_INPUT_MAX_AGE_MS		(uint16_t)(1000u)
+#endif
+
+#if (SNAKE_INPUT_LEN & (SNAKE_INPUT_LEN - 1)) != 0
+#error "SNAKE_INPUT_LEN must be a power of 2"
+#endif
+
+/* Bins of the queueing latency histogram: 0, 1, 2~3, 4~7 ... ms, the last
+ * bin counts all the longer latencies */
+#define SNAKE_INPUT_HIST_BINS		(11u)
+
+/* Path a key came by, the latency is accounted per source */
+typedef enum
+{
+	INPUT_SOURCE_TCP,			/* TCP stream (also UART, host script) */
+	INPUT_SOURCE_UDP,			/* UDP control datagrams */
+	INPUT_SOURCES
+} snake_input_source_e;
+
+typedef enum
+{
+	INPUT_POLICY_ONE_PER_TICK,	/* one key per tick, the rest waits for the next ticks */
+	INPUT_POLICY_LATEST			/* all the keys are popped, the newest wins (coalesced) */
+} snake_input_policy_e;
+
+/* Policy of the platform's control queue */
+#ifndef SNAKE_INPUT_POLICY
+#define SNAKE_INPUT_POLICY			INPUT_POLICY_ONE_PER_TICK
+#endif
+
+typedef struct snake_input_cmd_tag
+{
+	char key;
+	uint8_t source;		/* snake_input_source_e */
+	uint16_t stamp;		/* platform_msTickGet() when pushed */
+} snake_input_cmd_t;
+
+typedef struct snake_input_tag
+{
+	snake_input_cmd_t cmd[SNAKE_INPUT_LEN];
+	atomic_uint_least16_t head;		/* next slot to be written (producer) */
+	atomic_uint_least16_t tail;		/* next slot to be read (consumer) */
+	snake_input_policy_e policy;
+	uint16_t maxAgeMs;
+
+	/* producer counters */
+	uint32_t pushed;
+	uint32_t dropped;		/* queue full */
+
+	/* consumer counters */
+	uint32_t applied;		/* keys returned by snake_input_pop() */
+	uint32_t coalesced;		/* keys superseded by a newer one (INPUT_POLICY_LATEST) */
+	uint32_t stale;			/* keys older than maxAgeMs */
+	uint16_t latencyMax;	/* longest time a returned key has been queued, ms */
+	uint32_t latencyHist[INPUT_SOURCES][SNAKE_INPUT_HIST_BINS];	/* returned keys by the queued time */
+} snake_input_t;
+
+void snake_input_init(snake_input_t* input, snake_input_policy_e policy);
+uint8_t snake_input_push(snake_input_t* input, char key, uint16_t stamp, snake_input_source_e source);
+char snake_input_pop(snake_input_t* input, uint16_t now);
+
+#endif /* SNAKE_INPUT_H_ */
@@ -0,0 +1,509 @@
+/*
+ * Deterministic input/tick journal for a snake game (record & replay)
+ *
+ * snake_journal.c
+ *
+ * Records are stored in a ring buffer indexed by the absolute tick number
+ * (tick % SNAKE_JOURNAL_LEN), when the ring is full the oldest tick is
+ * overwritten. Replay starts at the beginning of a game (the oldest record
+ * flagged by JOURNAL_EV_NEW_GAME) or, when the start of the game was
+ * overwritten, at the oldest checkpoint within the ring - the snake's state
+ * of a running game is saved every SNAKE_JOURNAL_CKPT_TICKS ticks into two
+ * alternating slots.
+ *
+ * Platform independent - used by the MCU port as well as the host port.
+ */
+
+#include "snake_journal.h"
+#include "snake_function.h"
+
+/* Ring buffer of ticks */
+static journal_rec_t gJournal[SNAKE_JOURNAL_LEN];
+
+/* Absolute tick number of the oldest record and number of records */
+static uint32_t gFirstTick;
+static uint16_t gCount;
+
+static journal_mode_e gMode = JOURNAL_OFF;
+
+/* Mode set when the replay is finished */
+static journal_mode_e gResumeMode = JOURNAL_OFF;
+static uint8_t gReplayRequested;
+
+/* Record being filled by the current tick (record mode) */
+static journal_rec_t gCurrent;
+static uint8_t gCurrentOpen;
+static uint8_t gPendingEvent;
+
+/* Replay position - index of the replayed record (from the oldest one) */
+static uint16_t gCursor;
+static uint32_t gDivergences;
+
+/* Food state seen at the end of the previous tick */
+static foodstate_e gFoodState;
+
+/* Checkpoints of a running game and the next slot to be written */
+static journal_ckpt_t gCkpt[2];
+static uint8_t gCkptValid[2];
+static uint8_t gCkptNext;
+
+/* Absolute tick of the last replay start (game start or checkpoint) */
+static uint32_t gRestartTick;
+
+
+static inline journal_rec_t* journal_at(uint16_t idx)
+{
+	return &gJournal[(gFirstTick + idx) % SNAKE_JOURNAL_LEN];
+}
+
+
+/* Absolute tick number of the next record */
+static inline uint32_t journal_end(void)
+{
+	return gFirstTick + gCount;
+}
+
+
+/* Index of the first game start at or after the index, gCount if none */
+static uint16_t journal_find_game(uint16_t idx)
+{
+	while (idx < gCount && !(journal_at(idx)->event & JOURNAL_EV_NEW_GAME))
+	{
+		idx++;
+	}
+	return idx;
+}
+
+
+/* Checkpoint to start the replay from, NULL when the ring holds a game
+ * start older than any checkpoint within the ring */
+static const journal_ckpt_t* journal_checkpoint(void)
+{
+	const journal_ckpt_t* ckpt = NULL;
+
+	for (uint8_t slot = 0; slot < 2; slot++)
+	{
+		if (gCkptValid[slot] && gCkpt[slot].tick >= gFirstTick && gCkpt[slot].tick < journal_end() &&
+			(NULL == ckpt || gCkpt[slot].tick < ckpt->tick))
+		{
+			ckpt = &gCkpt[slot];
+		}
+	}
+
+	if (NULL != ckpt && gFirstTick + journal_find_game(0) <= ckpt->tick)
+	{
+		ckpt = NULL;
+	}
+
+	return ckpt;
+}
+
+
+/* Save the state of the game at the beginning of the tick */
+static void journal_save(journal_ckpt_t* ckpt, snake_t* snake, food_t* food, uint32_t tick)
+{
+	ckpt->tick = tick;
+	ckpt->cycle = snake->cycle;
+	ckpt->length = snake->length;
+	ckpt->freeCount = snake->freeCount;
+	ckpt->direction = (uint8_t)snake->direction;
+	ckpt->foodState = (uint8_t)food->state;
+	ckpt->foodX = (uint8_t)food->coord.x;
+	ckpt->foodY = (uint8_t)food->coord.y;
+	ckpt->foodTimeElapsed = food->time_elapsed;
+	ckpt->reserved = 0;
+
+	for (uint16_t idx = 0; idx < snake->length; idx++)
+	{
+		ckpt->body[idx] = *snake_body_at(snake, idx);
+	}
+	memcpy(ckpt->freeCells, snake->freeCells, snake->freeCount*sizeof(uint16_t));
+}
+
+
+/* Restore the state of the game (after snake_init()) */
+static void journal_restore(const journal_ckpt_t* ckpt, snake_t* snake, food_t* food)
+{
+	snake_restore(snake, ckpt->body, ckpt->length, ckpt->freeCells, ckpt->freeCount);
+	snake->cycle = ckpt->cycle;
+	snake->direction = (snake_dir_e)ckpt->direction;
+
+	food->state = (foodstate_e)ckpt->foodState;
+	food->coord.x = ckpt->foodX;
+	food->coord.y = ckpt->foodY;
+	food->time_elapsed = ckpt->foodTimeElapsed;
+	food->rePrintFood = 1;
+
+	gFoodState = food->state;
+}
+
+
+/* Events of the finished tick, food coords are filled into rec */
+static uint8_t journal_events(snake_t* snake, food_t* food, journal_rec_t* rec)
+{
+	uint8_t event = 0;
+
+	if (PLACED == food->state && PLACED != gFoodState)
+	{
+		event |= JOURNAL_EV_FOOD_PLACED;
+		rec->foodX = (uint8_t)food->coord.x;
+		rec->foodY = (uint8_t)food->coord.y;
+	}
+	if (EATEN == food->state && EATEN != gFoodState)
+	{
+		event |= JOURNAL_EV_FOOD_EATEN;
+	}
+	if (CRASHED == snake->state)
+	{
+		event |= JOURNAL_EV_CRASHED;
+	}
+	if (WON == snake->state)
+	{
+		event |= JOURNAL_EV_WON;
+	}
+	gFoodState = food->state;
+
+	return event;
+}
+
+
+/**
+  * @brief  Initialize the journal
+  *
+  * @note   JOURNAL_OFF and JOURNAL_RECORD clear the journal. JOURNAL_REPLAY
+  *         keeps it (e.g. loaded by snake_journal_load()) and replays it from
+  *         the next game start, then the journal is switched off.
+  *
+  * @param mode - journal mode
+  * @retval None
+  */
+void snake_journal_init(journal_mode_e mode)
+{
+	gCurrentOpen = 0;
+	gPendingEvent = 0;
+	gDivergences = 0;
+
+	if (JOURNAL_REPLAY == mode)
+	{
+		gMode = JOURNAL_OFF;
+		gResumeMode = JOURNAL_OFF;
+		gReplayRequested = 1;
+		return;
+	}
+
+	gMode = mode;
+	gReplayRequested = 0;
+	gFirstTick = 0;
+	gCount = 0;
+	gCursor = 0;
+	gCkptValid[0] = 0;
+	gCkptValid[1] = 0;
+	gCkptNext = 0;
+	gRestartTick = 0;
+}
+
+
+journal_mode_e snake_journal_mode(void)
+{
+	return gReplayRequested ? JOURNAL_REPLAY : gMode;
+}
+
+
+/**
+  * @brief  Replay the journal from the next game start
+  *
+  * @note   When the replay is finished, the former mode (recording) is resumed.
+  *
+  * @param None
+  * @retval None
+  */
+void snake_journal_request_replay(void)
+{
+	if (JOURNAL_REPLAY != gMode)
+	{
+		gResumeMode = gMode;
+		gReplayRequested = 1;
+	}
+}
+
+
+/**
+  * @brief  Mark beginning of a new game - call after snake_init()
+  *
+  * @note   A replay started from a checkpoint restores the snake and the food
+  *         of the checkpoint.
+  *
+  * @param snake - pointer to a snake structure
+  * @param food - pointer to a food structure
+  * @retval None
+  */
+void snake_journal_game_start(snake_t* snake, food_t* food)
+{
+	gFoodState = WAITING;
+
+	if (gReplayRequested)
+	{
+		const journal_ckpt_t* ckpt = journal_checkpoint();
+
+		gReplayRequested = 0;
+		gCurrentOpen = 0;
+
+		if (NULL != ckpt)
+		{
+			gCursor = (uint16_t)(ckpt->tick - gFirstTick);
+			journal_restore(ckpt, snake, food);
+			gMode = JOURNAL_REPLAY;
+			return;
+		}
+		gCursor = journal_find_game(0);
+		gMode = (gCursor < gCount) ? JOURNAL_REPLAY : gResumeMode;
+		return;
+	}
+
+	if (JOURNAL_REPLAY == gMode)
+	{
+		/* A replayed game ended differently than the recorded one */
+		if (gCursor < gCount && !(journal_at(gCursor)->event & JOURNAL_EV_NEW_GAME))
+		{
+			gDivergences++;
+			gCursor = journal_find_game(gCursor);
+		}
+		if (gCursor >= gCount)
+		{
+			gMode = gResumeMode;
+		}
+		return;
+	}
+
+	gPendingEvent = JOURNAL_EV_NEW_GAME;
+	gRestartTick = journal_end();
+}
+
+
+/**
+  * @brief  Journal hook of the platform_get_control()
+  *
+  * @note   Recording: the key and the randomizer state are stored.
+  *         Replay: the key and the randomizer state are taken from the
+  *         journal (the live key is ignored).
+  *
+  * @param key - key received by the platform (0 = none)
+  * @param seed - pointer to the randomizer state of the platform
+  * @retval key to be used by the tick
+  */
+char snake_journal_control(char key, uint16_t* seed)
+{
+	if (JOURNAL_RECORD == gMode)
+	{
+		gCurrent.seed = *seed;
+		gCurrent.control = (uint8_t)key;
+		gCurrent.event = gPendingEvent;
+		gCurrent.foodX = 0;
+		gCurrent.foodY = 0;
+		gCurrentOpen = 1;
+		gPendingEvent = 0;
+	}
+	else if (JOURNAL_REPLAY == gMode && gCursor < gCount)
+	{
+		journal_rec_t* rec = journal_at(gCursor);
+
+		*seed = rec->seed;
+		key = (char)rec->control;
+	}
+
+	return key;
+}
+
+
+/**
+  * @brief  Close the tick - call at the end of each game tick (also the last one)
+  *
+  * @note   Recording: the record is appended (the oldest may be overwritten),
+  *         a running game is checkpointed every SNAKE_JOURNAL_CKPT_TICKS
+  *         ticks (postponed while paused).
+  *         Replay: food events are compared with the journal (divergences).
+  *
+  * @param snake - pointer to a snake structure
+  * @param food - pointer to a food structure
+  * @retval None
+  */
+void snake_journal_tick_end(snake_t* snake, food_t* food)
+{
+	if (JOURNAL_RECORD == gMode && gCurrentOpen)
+	{
+		gCurrent.event |= journal_events(snake, food, &gCurrent);
+		gCurrentOpen = 0;
+
+		if (gCount == SNAKE_JOURNAL_LEN)
+		{
+			gFirstTick++;
+			gCount--;
+		}
+		gJournal[(gFirstTick + gCount) % SNAKE_JOURNAL_LEN] = gCurrent;
+		gCount++;
+
+		if (PLAYING == snake->state && PAUSE != snake->direction &&
+			journal_end() - gRestartTick >= SNAKE_JOURNAL_CKPT_TICKS)
+		{
+			journal_save(&gCkpt[gCkptNext], snake, food, journal_end());
+			gCkptValid[gCkptNext] = 1;
+			gCkptNext ^= 1;
+			gRestartTick = journal_end();
+		}
+	}
+	else if (JOURNAL_REPLAY == gMode && gCursor < gCount)
+	{
+		journal_rec_t* rec = journal_at(gCursor);
+		journal_rec_t replayed = { 0 };
+		uint8_t event = journal_events(snake, food, &replayed);
+
+		if (event != (rec->event & ~JOURNAL_EV_NEW_GAME) ||
+			replayed.foodX != rec->foodX || replayed.foodY != rec->foodY)
+		{
+			gDivergences++;
+		}
+
+		if (++gCursor >= gCount)
+		{
+			gMode = gResumeMode;
+		}
+	}
+}
+
+
+/* Number of bytes of the journal stream (header, checkpoint and records) */
+uint32_t snake_journal_size(void)
+{
+	uint32_t ckptSize = (NULL != journal_checkpoint()) ? sizeof(journal_ckpt_t) : 0;
+
+	return sizeof(journal_hdr_t) + ckptSize + (uint32_t)gCount * sizeof(journal_rec_t);
+}
+
+
+/**
+  * @brief  Read a part of the journal stream (header, checkpoint and records, oldest first)
+  *
+  * @note   The stream may be read in chunks of any size, e.g. to be sent
+  *         over UART or TCP. Reading should not be interleaved with ticks,
+  *         otherwise the stream is not consistent.
+  *
+  * @param offset - offset within the stream
+  * @param buf - destination buffer
+  * @param len - size of the buffer
+  * @retval number of bytes read (0 = end of the stream)
+  */
+uint32_t snake_journal_read(uint32_t offset, uint8_t* buf, uint32_t len)
+{
+	const journal_ckpt_t* ckpt = journal_checkpoint();
+	uint16_t ckptSize = (NULL != ckpt) ? sizeof(journal_ckpt_t) : 0;
+	journal_hdr_t hdr = { SNAKE_JOURNAL_MAGIC, gCount, sizeof(journal_rec_t), gFirstTick, ckptSize, 0 };
+	uint32_t size = snake_journal_size();
+	uint32_t done = 0;
+
+	while (done < len && offset < size)
+	{
+		const uint8_t* src;
+		uint32_t avail;
+
+		if (offset < sizeof(journal_hdr_t))
+		{
+			src = (const uint8_t*)&hdr + offset;
+			avail = sizeof(journal_hdr_t) - offset;
+		}
+		else if (offset < sizeof(journal_hdr_t) + ckptSize)
+		{
+			src = (const uint8_t*)ckpt + offset - sizeof(journal_hdr_t);
+			avail = sizeof(journal_hdr_t) + ckptSize - offset;
+		}
+		else
+		{
+			uint32_t recOffset = offset - sizeof(journal_hdr_t) - ckptSize;
+
+			src = (const uint8_t*)journal_at((uint16_t)(recOffset / sizeof(journal_rec_t)))
+				  + recOffset % sizeof(journal_rec_t);
+			avail = sizeof(journal_rec_t) - recOffset % sizeof(journal_rec_t);
+		}
+
+		if (avail > len - done)
+		{
+			avail = len - done;
+		}
+		memcpy(buf + done, src, avail);
+		done += avail;
+		offset += avail;
+	}
+
+	return done;
+}
+
+
+/**
+  * @brief  Load a journal stream (e.g. dumped from the target)
+  *
+  * @note   If the stream holds more records than SNAKE_JOURNAL_LEN,
+  *         the newest ones are kept. Use snake_journal_init(JOURNAL_REPLAY)
+  *         to replay it, snake_journal_can_replay() tells whether it holds
+  *         a game start or a checkpoint.
+  *
+  * @param data - journal stream
+  * @param len - length of the stream
+  * @retval number of loaded records, 0 on invalid stream
+  */
+uint32_t snake_journal_load(const uint8_t* data, uint32_t len)
+{
+	journal_hdr_t hdr;
+	uint32_t skip;
+	const uint8_t* records;
+
+	if (len < sizeof(journal_hdr_t))
+	{
+		return 0;
+	}
+	memcpy(&hdr, data, sizeof(journal_hdr_t));
+
+	if (SNAKE_JOURNAL_MAGIC != hdr.magic || sizeof(journal_rec_t) != hdr.recSize ||
+		(0 != hdr.ckptSize && sizeof(journal_ckpt_t) != hdr.ckptSize) ||
+		len < sizeof(journal_hdr_t) + hdr.ckptSize + (uint32_t)hdr.count * sizeof(journal_rec_t))
+	{
+		return 0;
+	}
+	records = data + sizeof(journal_hdr_t) + hdr.ckptSize;
+
+	gCkptValid[0] = (0 != hdr.ckptSize);
+	gCkptValid[1] = 0;
+	gCkptNext = 0;
+	if (gCkptValid[0])
+	{
+		memcpy(&gCkpt[0], data + sizeof(journal_hdr_t), sizeof(journal_ckpt_t));
+	}
+
+	skip = (hdr.count > SNAKE_JOURNAL_LEN) ? hdr.count - SNAKE_JOURNAL_LEN : 0;
+
+	gMode = JOURNAL_OFF;
+	gFirstTick = hdr.firstTick + skip;
+	gCount = (uint16_t)(hdr.count - skip);
+	gCursor = 0;
+
+	for (uint16_t idx = 0; idx < gCount; idx++)
+	{
+		memcpy(journal_at(idx),
+			   records + (skip + idx) * sizeof(journal_rec_t),
+			   sizeof(journal_rec_t));
+	}
+
+	return gCount;
+}
+
+
+/* Whether the journal holds a game start or a checkpoint to replay from */
+uint8_t snake_journal_can_replay(void)
+{
+	return (NULL != journal_checkpoint()) || (journal_find_game(0) < gCount);
+}
+
+
+/* Number of replayed ticks which did not match the journal */
+uint32_t snake_journal_divergences(void)
+{
+	return gDivergences;
+}
@@ -0,0 +1,107 @@
+/*
+ * Deterministic input/tick journal for a snake game (record & replay)
+ *
+ * snake_journal.h
+ *
+ * Each game tick appends one record to a RAM ring buffer: the randomizer
+ * state at the beginning of the tick, the control key consumed by the tick
+ * and the food event of the tick. The journal may be read out (UART, TCP)
+ * and fed back - the replayed ticks take the key and the randomizer state
+ * from the journal, so the game is reproduced bit-exactly on the target
+ * and in the host build (Host/snake_host -r).
+ *
+ * A game longer than the ring is checkpointed every SNAKE_JOURNAL_CKPT_TICKS
+ * ticks (snake and food state), so its tail can be replayed once the game
+ * start has been overwritten.
+ *
+ * Hooks:
+ *  platform_get_control()  - snake_journal_control() on the key and seed
+ *  game loop               - snake_journal_game_start() after snake_init()
+ *                            snake_journal_tick_end() at the end of a tick
+ */
+
+#ifndef SNAKE_JOURNAL_H_
+#define SNAKE_JOURNAL_H_
+
+#include "snake_port.h"
+
+/* Number of journal records (ticks) kept in RAM, 6 bytes each */
+#ifndef SNAKE_JOURNAL_LEN
+#define SNAKE_JOURNAL_LEN			(uint16_t)(1024u)
+#endif
+
+/* Ticks between two checkpoints of a running game, two checkpoints are kept
+ * so the older one still within the ring covers at least this many ticks */
+#ifndef SNAKE_JOURNAL_CKPT_TICKS
+#define SNAKE_JOURNAL_CKPT_TICKS	(uint16_t)(SNAKE_JOURNAL_LEN/2u)
+#endif
+
+/* Journal stream identification "SNJ2" */
+#define SNAKE_JOURNAL_MAGIC			(uint32_t)(0x324A4E53u)
+
+/* Record event flags */
+#define JOURNAL_EV_NEW_GAME			(uint8_t)(0x01u)
+#define JOURNAL_EV_FOOD_PLACED		(uint8_t)(0x02u)
+#define JOURNAL_EV_FOOD_EATEN		(uint8_t)(0x04u)
+#define JOURNAL_EV_CRASHED			(uint8_t)(0x08u)
+#define JOURNAL_EV_WON				(uint8_t)(0x10u)
+
+typedef enum { JOURNAL_OFF, JOURNAL_RECORD, JOURNAL_REPLAY } journal_mode_e;
+
+/* One tick */
+typedef struct journal_rec_tag
+{
+	uint16_t seed;		/* randomizer state at the beginning of the tick */
+	uint8_t control;	/* key consumed by platform_get_control(), 0 = none */
+	uint8_t event;		/* JOURNAL_EV_* */
+	uint8_t foodX;		/* food coords when JOURNAL_EV_FOOD_PLACED */
+	uint8_t foodY;
+} journal_rec_t;
+
+/* Game state at the beginning of a tick - replay start of a game whose
+ * start was overwritten. The snake is never paused in a checkpoint. */
+typedef struct journal_ckpt_tag
+{
+	uint32_t tick;		/* number of the first record replayed from the checkpoint */
+	uint32_t cycle;		/* snake->cycle */
+	uint16_t length;	/* snake->length */
+	uint16_t freeCount;	/* snake->freeCount */
+	uint8_t direction;	/* snake->direction */
+	uint8_t foodState;	/* food->state */
+	uint8_t foodX;		/* food->coord */
+	uint8_t foodY;
+	uint16_t foodTimeElapsed;	/* food->time_elapsed */
+	uint16_t reserved;
+	coord_t body[SNAKE_MAX_LNG];	/* from the tail to the head */
+	uint16_t freeCells[FOOD_CELLS];	/* free cells set in the order of the food draws */
+} journal_ckpt_t;
+
+/* Stream header followed by the checkpoint (if ckptSize != 0) and 'count'
+ * records - oldest first, little endian */
+typedef struct journal_hdr_tag
+{
+	uint32_t magic;		/* SNAKE_JOURNAL_MAGIC */
+	uint16_t count;		/* number of records */
+	uint16_t recSize;	/* sizeof(journal_rec_t) */
+	uint32_t firstTick;	/* number of the first record (older ones were overwritten) */
+	uint16_t ckptSize;	/* sizeof(journal_ckpt_t), 0 = replay from a game start */
+	uint16_t reserved;
+} journal_hdr_t;
+
+/* Maximal size of the journal stream */
+#define SNAKE_JOURNAL_STREAM_MAX	(sizeof(journal_hdr_t) + sizeof(journal_ckpt_t) + \
+									 SNAKE_JOURNAL_LEN*sizeof(journal_rec_t))
+
+void snake_journal_init(journal_mode_e mode);
+journal_mode_e snake_journal_mode(void);
+void snake_journal_request_replay(void);
+void snake_journal_game_start(snake_t* snake, food_t* food);
+char snake_journal_control(char key, uint16_t* seed);
+void snake_journal_tick_end(snake_t* snake, food_t* food);
+uint32_t snake_journal_size(void);
+uint32_t snake_journal_read(uint32_t offset, uint8_t* buf, uint32_t len);
+uint32_t snake_journal_load(const uint8_t* data, uint32_t len);
+uint8_t snake_journal_can_replay(void);
+uint32_t snake_journal_divergences(void);
+
+#endif /* SNAKE_JOURNAL_H_ */
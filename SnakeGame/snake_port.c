@@ -9,6 +9,8 @@
  */
 
 #include "snake_port.h"
+#include "snake_journal.h"
+#include "server_udp.h"
 
 
 #define SNAKE_SERVER_PORT	(uint16_t)(8000u)
@@ -19,15 +21,36 @@ extern ADC_HandleTypeDef hadc1;
 /* Randomizer seed */
 static uint16_t gRandSeed;
 
-/* variable for controlling snake's direction */
-static char gKeyBoardButton;
+/* queue of keys controlling snake's direction (TCP -> game loop) */
+static snake_input_t gInput;
+
+/* direction restored by the pause key (reset for each game) */
+static snake_dir_e gPrevDirection = RIGHT;
+
+/* queues and pause directions of the multiplayer arena players */
+static snake_input_t gPlayerInput[SNAKE_PLAYERS_MAX];
+static snake_dir_e gPlayerPrevDirection[SNAKE_PLAYERS_MAX];
+static uint8_t gPlayerAttached[SNAKE_PLAYERS_MAX];
+
+/* snake colors of the arena players */
+static const uint16_t gPlayerColor[] = { MAGENTA, CYAN, YELLOW, BLUE };
+
+static void platform_apply_control(snake_dir_e* current, snake_dir_e* prev, snake_dir_e direction);
+static void platform_draw_cell_color(uint16_t x, uint16_t y, uint16_t color);
 
 
 /* wrapper around actual control implementation - start */
 static void platform_control_init(void)
 {
+	  snake_input_init(&gInput, SNAKE_INPUT_POLICY);
+
 	  /* Start TCP server on the address 192.168.100.1:8000 */
 	  tcp_server_init(SNAKE_SERVER_PORT);
+
+#if SERVER_UDP_CONTROL
+	  /* Control datagrams on the same port number (UDP) */
+	  server_udp_init(SNAKE_SERVER_PORT);
+#endif
 }
 
 
@@ -39,18 +62,79 @@ static void platform_display_init(void)
 
 
 /**
-  * @brief  Function to set the gKeyBoardButton
+  * @brief  Function to queue a key for the platform_get_control()
   *
   * @note This function must be called in controlling callback or ISR
-  *       function, because it directly stores into gKeyBoardButton
-  *       which is further used by platform_get_control()
+  *       function (single producer of the gInput queue). When the queue
+  *       is full, the key is dropped (counted by the queue).
   *
-  * @param  None
+  * @param  c - received key
   * @retval None
   */
 void platform_snake_set_control(char c)
 {
-	gKeyBoardButton = c;
+	platform_snake_set_control_from(c, INPUT_SOURCE_TCP);
+}
+
+
+/* Same as platform_snake_set_control(), the key came by the given path
+ * (e.g. UDP control datagrams) - its latency is accounted separately */
+void platform_snake_set_control_from(char c, snake_input_source_e source)
+{
+	(void)snake_input_push(&gInput, c, platform_msTickGet(), source);
+}
+
+
+/* Counters of the control queue (dropped, coalesced, stale keys, latency) */
+const snake_input_t* platform_input_stats(void)
+{
+	return &gInput;
+}
+
+
+/**
+  * @brief  Bind a controller (e.g. TCP connection) to an arena player
+  *
+  * @note   The player's queue is emptied, so this function must be called
+  *         from the producer context (controlling callback) as the pushes.
+  *
+  * @param  player - player number, < SNAKE_PLAYERS_MAX
+  * @retval None
+  */
+void platform_player_attach(uint8_t player)
+{
+	snake_input_init(&gPlayerInput[player], SNAKE_INPUT_POLICY);
+	gPlayerPrevDirection[player] = RIGHT;
+	gPlayerAttached[player] = 1;
+}
+
+
+/* The controller of the player is gone, its snake leaves the arena */
+void platform_player_detach(uint8_t player)
+{
+	gPlayerAttached[player] = 0;
+}
+
+
+uint8_t platform_player_attached(uint8_t player)
+{
+	return gPlayerAttached[player];
+}
+
+
+/**
+  * @brief  Function to queue a key for an arena player
+  *
+  * @note   Same as platform_snake_set_control(), one queue per player.
+  *
+  * @param  player - player number, < SNAKE_PLAYERS_MAX
+  * @param  c - received key
+  * @param  source - path the key came by (latency histogram)
+  * @retval None
+  */
+void platform_player_set_control(uint8_t player, char c, snake_input_source_e source)
+{
+	(void)snake_input_push(&gPlayerInput[player], c, platform_msTickGet(), source);
 }
 
 
@@ -89,6 +173,14 @@ void platform_init_randomizer(void)
 void platform_refresh_hw(void)
 {
     fillScreen(BLACK);
+
+    /* New game is always resumed from the pause to the right, so a journal
+     * replay of the game does not depend on the former games */
+    gPrevDirection = RIGHT;
+    for (uint8_t player = 0; player < SNAKE_PLAYERS_MAX; player++)
+    {
+        gPlayerPrevDirection[player] = RIGHT;
+    }
 }
 
 
@@ -104,7 +196,26 @@ void platform_refresh_hw(void)
   */
 void platform_drawCell(uint16_t x, uint16_t y)
 {
+	platform_draw_cell_color(x, y, MAGENTA);
+}
+
+
+/**
+  * @brief  Draw a 'cell' of an arena player's snake (white border, player's color).
+  *
+  * @param x - coordination limited by ARENA_MAX_X.
+  * @param y - coordination limited by ARENA_MAX_Y.
+  * @param player - player number, < SNAKE_PLAYERS_MAX
+  * @retval None
+  */
+void platform_drawPlayerCell(uint16_t x, uint16_t y, uint8_t player)
+{
+	platform_draw_cell_color(x, y, gPlayerColor[player % (sizeof(gPlayerColor)/sizeof(gPlayerColor[0]))]);
+}
 
+
+static void platform_draw_cell_color(uint16_t x, uint16_t y, uint16_t color)
+{
 	drawRect(ARENA_OFFSET_X + CELL_SIZE*x,
 			ARENA_OFFSET_Y + CELL_SIZE*y,
 			CELL_SIZE,
@@ -115,7 +226,7 @@ void platform_drawCell(uint16_t x, uint16_t y)
 			ARENA_OFFSET_Y + CELL_SIZE*y + 1,
 			CELL_SIZE - 2,
 			CELL_SIZE - 2,
-			MAGENTA);
+			color);
 }
 
 
@@ -269,7 +380,7 @@ void platform_fatal(void)
 /**
   * @brief  Function to set snake's direction
   *
-  * @note   Function relies on the extKeyBoardButton and then casts
+  * @note   Function pops a key from the gInput queue and then casts
   *         this value into any direction/pause/quit of the snake.
   *         Function natively prevents change of 180° (LEFT-RIGHT)
   *
@@ -279,53 +390,76 @@ void platform_fatal(void)
 void platform_get_control(snake_t * snake)
 {
 	snake_dir_e direction = 0;
-	static snake_dir_e prev_direction = RIGHT;
 
-	/* this value should be set by platform_snake_set_control */
-	direction = (snake_dir_e)gKeyBoardButton;
+	/* key queued by platform_snake_set_control, journal records it
+	 * (or replaces it together with the randomizer state) */
+	direction = (snake_dir_e)snake_input_pop(&gInput, platform_msTickGet());
+	direction = (snake_dir_e)snake_journal_control((char)direction, &gRandSeed);
+
+	platform_apply_control(&snake->direction, &gPrevDirection, direction);
+}
+
 
+/**
+  * @brief  Function to set the direction of an arena player's snake
+  *
+  * @note   Same rules as platform_get_control(), the key is popped from
+  *         the player's queue (not journaled).
+  *
+  * @param player - player number, < SNAKE_PLAYERS_MAX
+  * @param direction - direction of the player's snake
+  * @retval None
+  */
+void platform_get_player_control(uint8_t player, snake_dir_e* direction)
+{
+	snake_dir_e key = (snake_dir_e)snake_input_pop(&gPlayerInput[player], platform_msTickGet());
+
+	platform_apply_control(direction, &gPlayerPrevDirection[player], key);
+}
+
+
+/* Casts a key into the direction/pause of a snake, 180° turns are refused */
+static void platform_apply_control(snake_dir_e* current, snake_dir_e* prev, snake_dir_e direction)
+{
 	if (direction == 0)
 	{
 		return;
 	}
 
-	/* reset the value as it has been already parsed */
-	platform_snake_set_control(0);
-
 	/* If received character is not a known function, do pause and save previous state */
 	if ((direction != LEFT) && (direction != RIGHT) && (direction != UP) &&
 		(direction != DOWN) && (direction != PAUSE) && (direction != QUIT))
 	{
-		prev_direction = snake->direction;
-		snake->direction = PAUSE;
+		*prev = *current;
+		*current = PAUSE;
 	}
 	else
 	{
 		/* If characters is a pause*/
 		if (direction == PAUSE)
 		{
-			if (snake->direction != PAUSE)
+			if (*current != PAUSE)
 			{
 				/* Save snake's direction and set pause*/
-				prev_direction = snake->direction;
-				snake->direction = PAUSE;
+				*prev = *current;
+				*current = PAUSE;
 			}
 			else
 			{
 				/* Retrieve former direction and run the snake */
-				snake->direction = prev_direction;
+				*current = *prev;
 			}
 		}
 		/* Finally if characters is a valid direction - change direction (not allowed 180° changes)*/
 		else
 		{
-			if ((snake->direction != PAUSE) &&
-				!(snake->direction == LEFT && direction == RIGHT) &&
-				!(snake->direction == RIGHT && direction == LEFT) &&
-				!(snake->direction == UP && direction == DOWN) &&
-				!(snake->direction == DOWN && direction == UP))
+			if ((*current != PAUSE) &&
+				!(*current == LEFT && direction == RIGHT) &&
+				!(*current == RIGHT && direction == LEFT) &&
+				!(*current == UP && direction == DOWN) &&
+				!(*current == DOWN && direction == UP))
 			{
-				snake->direction = direction;
+				*current = direction;
 			}
 		}
 	}
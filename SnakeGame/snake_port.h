@@ -14,6 +14,15 @@
 #include <string.h>
 #include <stdio.h>
 
+#include "snake_input.h"
+
+#ifdef SNAKE_HOST_PORT
+
+/* Headless host (PC) port - constants and stubs, see Host/snake_port_host.h */
+#include "snake_port_host.h"
+
+#else
+
 /* Platform - LCD dependencies */
 #include "tft.h"
 #include "functions.h"
@@ -72,10 +81,36 @@
 #define FOOD_MAX_Y			(uint16_t)(20)
 #define FOOD_MIN_Y			(uint16_t)(1)
 
+/* Platform blocking delay constants used by snake_delay() */
+#define PLATFORM_MAX_DELAY	HAL_MAX_DELAY
+#define PLATFORM_TICK_FREQ	uwTickFreq
+
+/* Hot engine code executed from ITCM RAM (see tcm.h) */
+#include "tcm.h"
+#define PLATFORM_FAST_FUNC	ITCM_FUNC
+
+#endif /* SNAKE_HOST_PORT */
+
+/* Number of arena cells and 32-bit words of the packed occupancy bitmap */
+#define ARENA_CELLS			(uint16_t)(ARENA_MAX_X*ARENA_MAX_Y)
+#define ARENA_OCC_WORDS		(uint16_t)((ARENA_CELLS + 31)/32)
+
+/* Number of cells where a food may be placed */
+#define FOOD_CELLS			(uint16_t)((FOOD_MAX_X - FOOD_MIN_X + 1)*(FOOD_MAX_Y - FOOD_MIN_Y + 1))
+
 /* General constants (applicable across platforms) */
 #define SNAKE_MAX_LNG		(uint16_t)(250)
 #define SNAKE_WON_LIMIT		(uint16_t)(SNAKE_MAX_LNG - 1)
 
+/* Multiplayer arena (snake_arena.h) - number of players and whether the
+ * game loop runs the arena instead of the single snake */
+#ifndef SNAKE_PLAYERS_MAX
+#define SNAKE_PLAYERS_MAX	(uint8_t)(4)
+#endif
+#ifndef SNAKE_MULTIPLAYER
+#define SNAKE_MULTIPLAYER	0
+#endif
+
 /* Definition, where snake starts and how is long */
 #define SNAKE_INIT_X_CORD	(uint16_t)(1)
 #define SNAKE_INIT_Y_CORD	(uint16_t)(10)
@@ -88,9 +123,6 @@
 #define GENERAL_ERROR		(uint16_t)(-1)
 #define INVALID_COORDS		(uint16_t)(-1)
 
-/* Number of maximal iterations for randomizer */
-#define FOOD_MAX_ITER		(uint16_t)(10)
-
 typedef enum { UP = 'W', DOWN = 'S', LEFT =  'A', RIGHT = 'D', PAUSE = 'P', QUIT = 'Q' } snake_dir_e;
 
 typedef enum { WAITING, PLACED, EATEN } foodstate_e;
@@ -106,11 +138,18 @@ typedef struct coord_tag
 typedef struct snake_tag
 {
 	snake_dir_e direction;
-	coord_t body[SNAKE_MAX_LNG];
+	coord_t body[SNAKE_MAX_LNG];	/* ring buffer, use snake_body_at() & co. */
+	uint16_t head;
+	uint16_t tail;
 	uint16_t length;
+	uint32_t occupancy[ARENA_OCC_WORDS];
+	uint16_t freeCells[FOOD_CELLS];		/* food cells not covered by the body (dense) */
+	uint16_t freeIndex[ARENA_CELLS];	/* position of a cell within freeCells */
+	uint16_t freeCount;
 	coord_t ghost;
 	uint8_t printWholeSnake;
 	snake_state_e state;
+	uint32_t cycle;		/* incremented each game cycle (to know, when to generate a snake's food) */
 } snake_t;
 
 typedef struct food_tag
@@ -138,5 +177,15 @@ void platform_refresh_hw(void);
 void platform_display_border(void);
 void platform_print_text(char *str, uint16_t length, uint16_t color);
 void platform_snake_set_control(char c);
+void platform_snake_set_control_from(char c, snake_input_source_e source);
+const snake_input_t* platform_input_stats(void);
+
+/* Multiplayer control - one input queue per player (snake_arena.h) */
+void platform_player_attach(uint8_t player);
+void platform_player_detach(uint8_t player);
+uint8_t platform_player_attached(uint8_t player);
+void platform_player_set_control(uint8_t player, char c, snake_input_source_e source);
+void platform_get_player_control(uint8_t player, snake_dir_e* direction);
+void platform_drawPlayerCell(uint16_t x, uint16_t y, uint8_t player);
 
 #endif /* SNAKE_PORT_H_ */
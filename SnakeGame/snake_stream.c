@@ -0,0 +1,154 @@
+/*
+ * Game state stream for a snake game (snake_functions)
+ *
+ * snake_stream.c
+ *
+ * Frames are encoded byte by byte (no struct packing), so the layout is
+ * the same on the target and on the host.
+ *
+ * Platform independent - used by the MCU port as well as the host port.
+ */
+
+#include "snake_stream.h"
+#include "snake_function.h"
+
+
+static inline uint8_t* stream_put16(uint8_t* dst, uint16_t val)
+{
+	dst[0] = (uint8_t)val;
+	dst[1] = (uint8_t)(val >> 8);
+	return dst + 2;
+}
+
+
+static inline uint8_t* stream_put_cell(uint8_t* dst, const coord_t* cell)
+{
+	dst[0] = (uint8_t)cell->x;
+	dst[1] = (uint8_t)cell->y;
+	return dst + 2;
+}
+
+
+/* Frame header, the length is filled by stream_finish() */
+static uint8_t* stream_header(snake_stream_t* stream, snake_t* snake, uint8_t* buf, uint8_t type)
+{
+	uint8_t* dst = buf;
+
+	*dst++ = type;
+	*dst++ = 0;
+	dst = stream_put16(dst, 0);
+	dst = stream_put16(dst, (uint16_t)stream->tick);
+	dst = stream_put16(dst, (uint16_t)(stream->tick >> 16));
+	dst = stream_put16(dst, (uint16_t)(snake->length - SNAKE_INIT_LNG));
+	*dst++ = (uint8_t)snake->state;
+	*dst++ = (uint8_t)snake->direction;
+
+	return dst;
+}
+
+
+static uint16_t stream_finish(uint8_t* buf, uint8_t* end)
+{
+	uint16_t len = (uint16_t)(end - buf);
+
+	(void)stream_put16(&buf[2], len);
+	return len;
+}
+
+
+/**
+  * @brief  Initialize the encoder - call after snake_init()
+  *
+  * @param stream - pointer to an encoder
+  * @retval None
+  */
+void snake_stream_init(snake_stream_t* stream)
+{
+	stream->tick = 0;
+	stream->foodState = WAITING;
+}
+
+
+/**
+  * @brief  Encode the delta of the finished tick - call once per tick
+  *
+  * @note   Uses the same data as snake_display(): the snake's head and the
+  *         ghost (erased tail) of the move. A paused or finished snake
+  *         does not move, then only the header (score, state) is sent.
+  *
+  * @param stream - pointer to an encoder
+  * @param snake - pointer to a snake structure
+  * @param food - pointer to a food structure
+  * @param buf - destination, at least SNAKE_STREAM_DELTA_MAX bytes
+  * @retval length of the frame
+  */
+uint16_t snake_stream_delta(snake_stream_t* stream, snake_t* snake, food_t* food, uint8_t* buf)
+{
+	uint8_t* dst;
+	uint8_t flags = 0;
+
+	stream->tick++;
+	dst = stream_header(stream, snake, buf, SNAKE_STREAM_DELTA);
+
+	if (PAUSE != snake->direction && PLAYING == snake->state)
+	{
+		flags |= SNAKE_STREAM_F_HEAD;
+		dst = stream_put_cell(dst, snake_head(snake));
+
+		if (INVALID_COORDS != snake->ghost.x && INVALID_COORDS != snake->ghost.y)
+		{
+			flags |= SNAKE_STREAM_F_TAIL;
+			dst = stream_put_cell(dst, &snake->ghost);
+		}
+	}
+
+	if (PLACED == food->state && PLACED != stream->foodState)
+	{
+		flags |= SNAKE_STREAM_F_FOOD;
+		dst = stream_put_cell(dst, &food->coord);
+	}
+	if (EATEN == food->state && EATEN != stream->foodState)
+	{
+		flags |= SNAKE_STREAM_F_EATEN;
+	}
+	stream->foodState = food->state;
+
+	buf[1] = flags;
+	return stream_finish(buf, dst);
+}
+
+
+/**
+  * @brief  Encode the whole board of the current tick
+  *
+  * @note   Does not change the encoder state, may be called (after
+  *         snake_stream_delta()) for any number of clients.
+  *
+  * @param stream - pointer to an encoder
+  * @param snake - pointer to a snake structure
+  * @param food - pointer to a food structure
+  * @param buf - destination, at least SNAKE_STREAM_KEYFRAME_MAX bytes
+  * @retval length of the frame
+  */
+uint16_t snake_stream_keyframe(snake_stream_t* stream, snake_t* snake, food_t* food, uint8_t* buf)
+{
+	uint8_t* dst = stream_header(stream, snake, buf, SNAKE_STREAM_KEYFRAME);
+
+	if (PLACED == food->state)
+	{
+		dst = stream_put_cell(dst, &food->coord);
+	}
+	else
+	{
+		*dst++ = SNAKE_STREAM_NO_FOOD;
+		*dst++ = SNAKE_STREAM_NO_FOOD;
+	}
+
+	dst = stream_put16(dst, snake->length);
+	for (uint16_t idx = 0; idx < snake->length; idx++)
+	{
+		dst = stream_put_cell(dst, snake_body_at(snake, idx));
+	}
+
+	return stream_finish(buf, dst);
+}
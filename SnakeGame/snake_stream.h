@@ -0,0 +1,61 @@
+/*
+ * Game state stream for a snake game (snake_functions)
+ *
+ * snake_stream.h
+ *
+ * Compact binary frames describing the board as snake_display() draws it,
+ * so a remote client may render exactly the state the board shows:
+ *
+ *  delta    - one per tick: new head, erased tail, placed food, score, state
+ *  keyframe - the whole snake and the food, sent to a client which joins
+ *             or which skipped a delta (then deltas continue)
+ *
+ * Frame layout (little endian):
+ *
+ *  offset  size  header (SNAKE_STREAM_HDR_LEN)
+ *   0      1     type     SNAKE_STREAM_DELTA / SNAKE_STREAM_KEYFRAME
+ *   1      1     flags    SNAKE_STREAM_F_* (delta)
+ *   2      2     len      length of the whole frame
+ *   4      4     tick     stream tick, deltas of a client are consecutive
+ *   8      2     score    snake's length - SNAKE_INIT_LNG
+ *   10     1     state    snake_state_e
+ *   11     1     dir      snake_dir_e (ASCII key)
+ *
+ *  delta: x,y (1+1 bytes) of the head, of the erased tail and of the
+ *         placed food, each only when its flag is set
+ *  keyframe: food x,y (SNAKE_STREAM_NO_FOOD if none), u16 length and
+ *         length * x,y of the body from the tail to the head
+ */
+
+#ifndef SNAKE_STREAM_H_
+#define SNAKE_STREAM_H_
+
+#include "snake_port.h"
+
+#define SNAKE_STREAM_DELTA			(uint8_t)(0x01u)
+#define SNAKE_STREAM_KEYFRAME		(uint8_t)(0x02u)
+
+/* Delta flags */
+#define SNAKE_STREAM_F_HEAD			(uint8_t)(0x01u)	/* head moved to x,y */
+#define SNAKE_STREAM_F_TAIL			(uint8_t)(0x02u)	/* tail cell x,y erased */
+#define SNAKE_STREAM_F_FOOD			(uint8_t)(0x04u)	/* food placed to x,y */
+#define SNAKE_STREAM_F_EATEN		(uint8_t)(0x08u)	/* food eaten by the head */
+
+#define SNAKE_STREAM_NO_FOOD		(uint8_t)(0xFFu)
+
+#define SNAKE_STREAM_HDR_LEN		(12u)
+#define SNAKE_STREAM_DELTA_MAX		(SNAKE_STREAM_HDR_LEN + 3u*2u)
+#define SNAKE_STREAM_KEYFRAME_MAX	(SNAKE_STREAM_HDR_LEN + 2u + 2u + 2u*SNAKE_MAX_LNG)
+
+/* Encoder state - one per game */
+typedef struct snake_stream_tag
+{
+	uint32_t tick;
+	foodstate_e foodState;	/* food state of the previous tick */
+} snake_stream_t;
+
+void snake_stream_init(snake_stream_t* stream);
+uint16_t snake_stream_delta(snake_stream_t* stream, snake_t* snake, food_t* food, uint8_t* buf);
+uint16_t snake_stream_keyframe(snake_stream_t* stream, snake_t* snake, food_t* food, uint8_t* buf);
+
+#endif /* SNAKE_STREAM_H_ */
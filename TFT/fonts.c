@@ -10,7 +10,7 @@
 
 #include "fonts.h"
 
-const uint8_t FreeMono12x7Bitmaps[]  = {
+const uint8_t FreeMono12x7Bitmaps[] FONT_DATA = {
   0x49, 0x24, 0x92, 0x48, 0x01, 0xF8, 0xE7, 0xE7, 0x67, 0x42, 0x42, 0x42,
   0x42, 0x09, 0x02, 0x41, 0x10, 0x44, 0x11, 0x1F, 0xF1, 0x10, 0x4C, 0x12,
   0x3F, 0xE1, 0x20, 0x48, 0x12, 0x04, 0x81, 0x20, 0x48, 0x04, 0x07, 0xA2,
@@ -134,7 +134,7 @@ const uint8_t FreeMono12x7Bitmaps[]  = {
   0xC0, 0xFF, 0xFF, 0xC0, 0xC1, 0x08, 0x42, 0x10, 0x84, 0x10, 0x4C, 0x42,
   0x10, 0x84, 0x26, 0x00, 0x38, 0x13, 0x38, 0x38 };
 
-const GFXglyph FreeMono12x7Glyphs[]  = {
+const GFXglyph FreeMono12x7Glyphs[] FONT_DATA = {
   {     0,   0,   0,  14,    0,    1 },   // 0x20 ' '
   {     0,   3,  15,  14,    6,  -14 },   // 0x21 '!'
   {     6,   8,   7,  14,    3,  -14 },   // 0x22 '"'
@@ -233,7 +233,7 @@ const GFXglyph FreeMono12x7Glyphs[]  = {
 
 GFXfont *gfxFont;
 
-const GFXfont mono12x7  = {
+const GFXfont mono12x7 FONT_DATA = {
 (uint8_t  *)FreeMono12x7Bitmaps,
 (GFXglyph *)FreeMono12x7Glyphs,
 0x20, 0x7E, 24 };
@@ -243,7 +243,7 @@ const GFXfont mono12x7  = {
 
 
 
-const uint8_t FreeMono9pt7bBitmaps[]  = {
+const uint8_t FreeMono9pt7bBitmaps[] FONT_DATA = {
   0xAA, 0xA8, 0x0C, 0xED, 0x24, 0x92, 0x48, 0x24, 0x48, 0x91, 0x2F, 0xE4,
   0x89, 0x7F, 0x28, 0x51, 0x22, 0x40, 0x08, 0x3E, 0x62, 0x40, 0x30, 0x0E,
   0x01, 0x81, 0xC3, 0xBE, 0x08, 0x08, 0x71, 0x12, 0x23, 0x80, 0x23, 0xB8,
@@ -316,7 +316,7 @@ const uint8_t FreeMono9pt7bBitmaps[]  = {
   0xBF, 0x29, 0x24, 0xA2, 0x49, 0x26, 0xFF, 0xF8, 0x89, 0x24, 0x8A, 0x49,
   0x2C, 0x61, 0x24, 0x30 };
 
-const GFXglyph FreeMono9pt7bGlyphs[]  = {
+const GFXglyph FreeMono9pt7bGlyphs[] FONT_DATA = {
   {     0,   0,   0,  11,    0,    1 },   // 0x20 ' '
   {     0,   2,  11,  11,    4,  -10 },   // 0x21 '!'
   {     3,   6,   5,  11,    2,  -10 },   // 0x22 '"'
@@ -413,13 +413,13 @@ const GFXglyph FreeMono9pt7bGlyphs[]  = {
   {   836,   3,  13,  11,    4,  -10 },   // 0x7D '}'
   {   841,   7,   3,  11,    2,   -6 } }; // 0x7E '~'
 
-const GFXfont mono9x7  = {
+const GFXfont mono9x7 FONT_DATA = {
   (uint8_t  *)FreeMono9pt7bBitmaps,
   (GFXglyph *)FreeMono9pt7bGlyphs,
   0x20, 0x7E, 18 };
 
 
-const uint8_t FreeMono18pt7bBitmaps[]  = {
+const uint8_t FreeMono18pt7bBitmaps[] FONT_DATA = {
   0x27, 0x77, 0x77, 0x77, 0x77, 0x22, 0x22, 0x20, 0x00, 0x6F, 0xF6, 0xF1,
   0xFE, 0x3F, 0xC7, 0xF8, 0xFF, 0x1E, 0xC3, 0x98, 0x33, 0x06, 0x60, 0xCC,
   0x18, 0x04, 0x20, 0x10, 0x80, 0x42, 0x01, 0x08, 0x04, 0x20, 0x10, 0x80,
@@ -679,7 +679,7 @@ const uint8_t FreeMono18pt7bBitmaps[]  = {
   0x10, 0x10, 0x10, 0x10, 0x10, 0x30, 0xE0, 0x1C, 0x00, 0x44, 0x0D, 0x84,
   0x36, 0x04, 0x40, 0x07, 0x00 };
 
-const GFXglyph FreeMono18pt7bGlyphs[]  = {
+const GFXglyph FreeMono18pt7bGlyphs[] FONT_DATA = {
   {     0,   0,   0,  21,    0,    1 },   // 0x20 ' '
   {     0,   4,  22,  21,    8,  -21 },   // 0x21 '!'
   {    11,  11,  10,  21,    5,  -20 },   // 0x22 '"'
@@ -776,12 +776,12 @@ const GFXglyph FreeMono18pt7bGlyphs[]  = {
   {  3054,   8,  25,  21,    7,  -20 },   // 0x7D '}'
   {  3079,  15,   5,  21,    3,  -11 } }; // 0x7E '~'
 
-const GFXfont mono18x7  = {
+const GFXfont mono18x7 FONT_DATA = {
   (uint8_t  *)FreeMono18pt7bBitmaps,
   (GFXglyph *)FreeMono18pt7bGlyphs,
   0x20, 0x7E, 35 };
 
-const uint8_t FreeMonoBold9pt7bBitmaps[]  = {
+const uint8_t FreeMonoBold9pt7bBitmaps[] FONT_DATA = {
   0xFF, 0xFF, 0xD2, 0x1F, 0x80, 0xEC, 0x89, 0x12, 0x24, 0x40, 0x36, 0x36,
   0x36, 0x7F, 0x7F, 0x36, 0xFF, 0xFF, 0x3C, 0x3C, 0x3C, 0x00, 0x18, 0xFF,
   0xFE, 0x3C, 0x1F, 0x1F, 0x83, 0x46, 0x8D, 0xF0, 0xC1, 0x83, 0x00, 0x61,
@@ -867,7 +867,7 @@ const uint8_t FreeMonoBold9pt7bBitmaps[]  = {
   0xFF, 0xFF, 0xFF, 0xF0, 0xCE, 0x66, 0x66, 0x33, 0x66, 0x66, 0xEC, 0x70,
   0x7C, 0xF3, 0xC0, 0xC0 };
 
-const GFXglyph FreeMonoBold9pt7bGlyphs[]  = {
+const GFXglyph FreeMonoBold9pt7bGlyphs[] FONT_DATA = {
   {     0,   0,   0,  11,    0,    1 },   // 0x20 ' '
   {     0,   3,  11,  11,    4,  -10 },   // 0x21 '!'
   {     5,   7,   5,  11,    2,  -10 },   // 0x22 '"'
@@ -964,13 +964,13 @@ const GFXglyph FreeMonoBold9pt7bGlyphs[]  = {
   {   988,   4,  14,  11,    4,  -10 },   // 0x7D '}'
   {   995,   9,   4,  11,    1,   -6 } }; // 0x7E '~'
 
-const GFXfont mono9x7bold  = {
+const GFXfont mono9x7bold FONT_DATA = {
   (uint8_t  *)FreeMonoBold9pt7bBitmaps,
   (GFXglyph *)FreeMonoBold9pt7bGlyphs,
   0x20, 0x7E, 18 };
 
 
-const uint8_t FreeMonoBold12pt7bBitmaps[]  = {
+const uint8_t FreeMonoBold12pt7bBitmaps[] FONT_DATA = {
   0xFF, 0xFF, 0xFF, 0xF6, 0x66, 0x60, 0x6F, 0x60, 0xE7, 0xE7, 0x62, 0x42,
   0x42, 0x42, 0x42, 0x11, 0x87, 0x30, 0xC6, 0x18, 0xC3, 0x31, 0xFF, 0xFF,
   0xF9, 0x98, 0x33, 0x06, 0x60, 0xCC, 0x7F, 0xEF, 0xFC, 0x66, 0x0C, 0xC3,
@@ -1117,7 +1117,7 @@ const uint8_t FreeMonoBold12pt7bBitmaps[]  = {
   0x79, 0x83, 0x06, 0x0C, 0x18, 0x31, 0xE3, 0x80, 0x3C, 0x37, 0xE7, 0x67,
   0xE6, 0x1C };
 
-const GFXglyph FreeMonoBold12pt7bGlyphs[]  = {
+const GFXglyph FreeMonoBold12pt7bGlyphs[] FONT_DATA = {
   {     0,   0,   0,  14,    0,    1 },   // 0x20 ' '
   {     0,   4,  15,  14,    5,  -14 },   // 0x21 '!'
   {     8,   8,   7,  14,    3,  -13 },   // 0x22 '"'
@@ -1214,13 +1214,13 @@ const GFXglyph FreeMonoBold12pt7bGlyphs[]  = {
   {  1707,   7,  19,  14,    4,  -14 },   // 0x7D '}'
   {  1724,  12,   4,  14,    1,   -7 } }; // 0x7E '~'
 
-const GFXfont mono12x7bold  = {
+const GFXfont mono12x7bold FONT_DATA = {
   (uint8_t  *)FreeMonoBold12pt7bBitmaps,
   (GFXglyph *)FreeMonoBold12pt7bGlyphs,
   0x20, 0x7E, 24 };
 
 
-const uint8_t FreeMonoBold18pt7bBitmaps[]  = {
+const uint8_t FreeMonoBold18pt7bBitmaps[] FONT_DATA = {
   0x77, 0xFF, 0xFF, 0xFF, 0xFF, 0xFB, 0x9C, 0xE7, 0x39, 0xC4, 0x03, 0xBF,
   0xFF, 0xB8, 0xF1, 0xFE, 0x3F, 0xC7, 0xF8, 0xFF, 0x1E, 0xC1, 0x98, 0x33,
   0x06, 0x60, 0xCC, 0x18, 0x0E, 0x1C, 0x0F, 0x3C, 0x1F, 0x3C, 0x1E, 0x3C,
@@ -1540,7 +1540,7 @@ const uint8_t FreeMonoBold18pt7bBitmaps[]  = {
   0xFC, 0x3F, 0x07, 0x00, 0x1E, 0x00, 0x1F, 0xC0, 0x1F, 0xF0, 0xDF, 0xFC,
   0xFF, 0x3F, 0xFB, 0x0F, 0xF8, 0x03, 0xF8, 0x00, 0x78 };
 
-const GFXglyph FreeMonoBold18pt7bGlyphs[]  = {
+const GFXglyph FreeMonoBold18pt7bGlyphs[] FONT_DATA = {
   {     0,   0,   0,  21,    0,    1 },   // 0x20 ' '
   {     0,   5,  22,  21,    8,  -21 },   // 0x21 '!'
   {    14,  11,  10,  21,    5,  -20 },   // 0x22 '"'
@@ -1637,7 +1637,7 @@ const GFXglyph FreeMonoBold18pt7bGlyphs[]  = {
   {  3762,  10,  27,  21,    6,  -21 },   // 0x7D '}'
   {  3796,  17,   8,  21,    2,  -13 } }; // 0x7E '~'
 
-const GFXfont mono18x7bold  = {
+const GFXfont mono18x7bold FONT_DATA = {
   (uint8_t  *)FreeMonoBold18pt7bBitmaps,
   (GFXglyph *)FreeMonoBold18pt7bGlyphs,
   0x20, 0x7E, 35 };
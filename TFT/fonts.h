@@ -19,6 +19,19 @@ typedef struct {
 	uint8_t   yAdvance;    ///< Newline distance (y axis)
 } GFXfont;
 
+/* Font tables in DTCM (tcm.h) - the text drawing reads them without flash
+ * wait states. All the tables move (about 20 KB of DTCM). */
+#ifndef FONTS_IN_DTCM
+#define FONTS_IN_DTCM 0
+#endif
+
+#if FONTS_IN_DTCM
+#include "tcm.h"
+#define FONT_DATA DTCM_CONST
+#else
+#define FONT_DATA
+#endif
+
 extern GFXfont *gfxFont;
 extern const GFXfont mono9x7;
 extern const GFXfont mono9x7bold;
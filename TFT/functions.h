@@ -18,6 +18,8 @@
 #define WHITE   0xFFFF
 
 
+uint16_t width(void);
+uint16_t height(void);
 void drawPixel(int16_t x, int16_t y, uint16_t color);
 void fillScreen(uint16_t color);
 void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
@@ -42,16 +42,27 @@
 #include "functions.h"
 #include "user_setting.h"
 #include "stdlib.h"
+#include "cpu_cycles.h"
+#include "tcm.h"
 
 
 /********************************************** NO CHNAGES AFTER THIS ************************************************/
 
 extern TIM_HandleTypeDef htim2;
 
+/* Busy wait in microseconds, TIM2 is a free running 1 MHz time base shared
+ * with the game tick scheduler, so its counter must not be reset here.
+ * The first calls come from readID() before tft_init() / tick_sched_start(),
+ * so the time base is started here when it is not running yet */
 void delay (uint32_t time)
 {
-	htim2.Instance->CNT = 0;
-	while(htim2.Instance->CNT == time);
+	if ((htim2.Instance->CR1 & TIM_CR1_CEN) == 0U)
+	{
+		(void)HAL_TIM_Base_Start(&htim2);
+	}
+
+	uint32_t start = htim2.Instance->CNT;
+	while((htim2.Instance->CNT - start) < time);
 
 #if NOP_AUX_IMPLEMENTATION
 	for(uint32_t a = 0; a < time; a++)
@@ -100,20 +111,39 @@ void PIN_OUTPUT (GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
 
 
 
- #define RD_ACTIVE  PIN_LOW(RD_PORT, RD_PIN)
- #define RD_IDLE    PIN_HIGH(RD_PORT, RD_PIN)
+/* Control lines are driven by single BSRR stores (bits 31~16 reset the
+ * pins, bits 15~0 set them), no read-modify-write and no call */
+#define PIN_LOW_BSRR(port, pin)   ((port)->BSRR = (uint32_t)(pin) << 16)
+#define PIN_HIGH_BSRR(port, pin)  ((port)->BSRR = (uint32_t)(pin))
+
+/* Busy wait of the bus timing, DWT cycle counter (started by CTL_INIT) */
+static inline void tft_wait_cycles(uint32_t cycles)
+{
+	uint32_t start = DWT->CYCCNT;
+	while ((DWT->CYCCNT - start) < cycles);
+}
+
+static inline void tft_cycles_enable(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->LAR = 0xC5ACCE55u;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+ #define RD_ACTIVE  PIN_LOW_BSRR(RD_PORT, RD_PIN)
+ #define RD_IDLE    PIN_HIGH_BSRR(RD_PORT, RD_PIN)
  #define RD_OUTPUT  PIN_OUTPUT(RD_PORT, RD_PIN)
- #define WR_ACTIVE  PIN_LOW(WR_PORT, WR_PIN)
- #define WR_IDLE    PIN_HIGH(WR_PORT, WR_PIN)
+ #define WR_ACTIVE  PIN_LOW_BSRR(WR_PORT, WR_PIN)
+ #define WR_IDLE    PIN_HIGH_BSRR(WR_PORT, WR_PIN)
  #define WR_OUTPUT  PIN_OUTPUT(WR_PORT, WR_PIN)
- #define CD_COMMAND PIN_LOW(CD_PORT, CD_PIN)
- #define CD_DATA    PIN_HIGH(CD_PORT, CD_PIN)
+ #define CD_COMMAND PIN_LOW_BSRR(CD_PORT, CD_PIN)
+ #define CD_DATA    PIN_HIGH_BSRR(CD_PORT, CD_PIN)
  #define CD_OUTPUT  PIN_OUTPUT(CD_PORT, CD_PIN)
- #define CS_ACTIVE  PIN_LOW(CS_PORT, CS_PIN)
- #define CS_IDLE    PIN_HIGH(CS_PORT, CS_PIN)
+ #define CS_ACTIVE  PIN_LOW_BSRR(CS_PORT, CS_PIN)
+ #define CS_IDLE    PIN_HIGH_BSRR(CS_PORT, CS_PIN)
  #define CS_OUTPUT  PIN_OUTPUT(CS_PORT, CS_PIN)
- #define RESET_ACTIVE  PIN_LOW(RESET_PORT, RESET_PIN)
- #define RESET_IDLE    PIN_HIGH(RESET_PORT, RESET_PIN)
+ #define RESET_ACTIVE  PIN_LOW_BSRR(RESET_PORT, RESET_PIN)
+ #define RESET_IDLE    PIN_HIGH_BSRR(RESET_PORT, RESET_PIN)
  #define RESET_OUTPUT  PIN_OUTPUT(RESET_PORT, RESET_PIN)
 
 
@@ -130,16 +160,41 @@ void PIN_OUTPUT (GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
 #define RD_IDLE2  {RD_IDLE; RD_IDLE;}
 #define RD_IDLE4  {RD_IDLE2; RD_IDLE2;}
 
-#define WR_STROBE { WR_ACTIVE; WR_IDLE; }         //PWLW=TWRL=50ns
-#define RD_STROBE RD_IDLE, RD_ACTIVE, RD_ACTIVE, RD_ACTIVE   //PWLR=TRDL=150ns
+/* Data is latched on the rising edge of WR, it is set up during the low pulse
+ * and held during the high one (timing in user_setting.h) */
+#define WR_STROBE { WR_ACTIVE; tft_wait_cycles(TFT_WR_LOW_CYCLES); WR_IDLE; tft_wait_cycles(TFT_WR_HIGH_CYCLES); }
+
+
+/* Data bus tables of user_setting.h, expanded from the pin map macros at
+ * compile time (TFT_BUS_LUTn(f, n) lists f(n) ... f(n + N - 1)) */
+#if TFT_BUS_LUT_IN_DTCM
+#define TFT_BUS_LUT DTCM_CONST
+#else
+#define TFT_BUS_LUT
+#endif
+
+#define TFT_BUS_LUT4(f, n)   f((n)), f((n) + 1u), f((n) + 2u), f((n) + 3u)
+#define TFT_BUS_LUT16(f, n)  TFT_BUS_LUT4(f, (n)), TFT_BUS_LUT4(f, (n) + 4u), \
+                             TFT_BUS_LUT4(f, (n) + 8u), TFT_BUS_LUT4(f, (n) + 12u)
+#define TFT_BUS_LUT64(f, n)  TFT_BUS_LUT16(f, (n)), TFT_BUS_LUT16(f, (n) + 16u), \
+                             TFT_BUS_LUT16(f, (n) + 32u), TFT_BUS_LUT16(f, (n) + 48u)
+#define TFT_BUS_LUT256(f, n) TFT_BUS_LUT64(f, (n)), TFT_BUS_LUT64(f, (n) + 64u), \
+                             TFT_BUS_LUT64(f, (n) + 128u), TFT_BUS_LUT64(f, (n) + 192u)
+
+const uint32_t tft_bsrr_d[256] TFT_BUS_LUT = { TFT_BUS_LUT256(TFT_BSRR_D, 0u) };
+const uint32_t tft_bsrr_e[256] TFT_BUS_LUT = { TFT_BUS_LUT256(TFT_BSRR_E, 0u) };
+const uint32_t tft_bsrr_f[256] TFT_BUS_LUT = { TFT_BUS_LUT256(TFT_BSRR_F, 0u) };
+
+const uint8_t tft_read_e[32] TFT_BUS_LUT = { TFT_BUS_LUT16(TFT_READ_E, 0u), TFT_BUS_LUT16(TFT_READ_E, 16u) };
+const uint8_t tft_read_f[16] TFT_BUS_LUT = { TFT_BUS_LUT16(TFT_READ_F, 0u) };
 
 
-#define write8(x)     { write_8(x); WRITE_DELAY; WR_STROBE; WR_IDLE; }
+#define write8(x)     { write_8(x); WR_STROBE; }
 #define write16(x)    { uint8_t h = (x)>>8, l = x; write8(h); write8(l); }
-#define READ_8(dst)   { RD_STROBE; READ_DELAY; dst = read_8(); RD_IDLE; RD_IDLE; } // read 250ns after RD_ACTIVE goes low
+#define READ_8(dst)   { RD_ACTIVE; tft_wait_cycles(TFT_RD_LOW_CYCLES); dst = read_8(); RD_IDLE; tft_wait_cycles(TFT_RD_HIGH_CYCLES); }
 #define READ_16(dst)  { uint8_t hi; READ_8(hi); READ_8(dst); dst |= (hi << 8); }
 
-#define CTL_INIT()   { RD_OUTPUT; WR_OUTPUT; CD_OUTPUT; CS_OUTPUT; RESET_OUTPUT; }
+#define CTL_INIT()   { tft_cycles_enable(); RD_OUTPUT; WR_OUTPUT; CD_OUTPUT; CS_OUTPUT; RESET_OUTPUT; }
 #define WriteCmd(x)  { CD_COMMAND; write16(x); CD_DATA; }
 #define WriteData(x) { write16(x); }
 #define SUPPORT_9488_555          //costs +230 bytes, 0.03s / 0.19s
@@ -278,8 +333,9 @@ void setWriteDir (void)
 
 
 
-static void pushColors_any(uint16_t cmd, uint8_t * block, int16_t n, uint8_t first, uint8_t flags)
+static ITCM_FUNC void pushColors_any(uint16_t cmd, uint8_t * block, int16_t n, uint8_t first, uint8_t flags)
 {
+    CPU_CYCLES_BEGIN(start);
     uint16_t color;
     uint8_t h, l;
 	uint8_t isconst = flags & 1;
@@ -313,6 +369,7 @@ static void pushColors_any(uint16_t cmd, uint8_t * block, int16_t n, uint8_t fir
         write16(color);
     }
     CS_IDLE;
+    CPU_CYCLES_END(CPU_CYCLES_PUSHCOLORS, start);
 }
 
 static void write24(uint16_t color)
@@ -3237,8 +3294,50 @@ void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
     drawFastVLine(x+w-1, y, h, color);
 }
 
-void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+#if !USING_16BIT_BUS
+/* Write n pixels of one colour after _MW. The data bus keeps its state
+ * between the WR strobes, so a colour with equal bytes (BLACK, WHITE ...) is
+ * driven once and only WR toggles, other colours alternate between the port
+ * states of the high and the low byte, looked up once per fill */
+static ITCM_FUNC void fillPixels(uint16_t color, uint32_t n)
 {
+    uint8_t hi = color >> 8, lo = color & 0xFF;
+    if (hi == lo) {
+        write_8(hi);
+        n *= 2;
+        for (; n >= 8; n -= 8) {
+            WR_STROBE;
+            WR_STROBE;
+            WR_STROBE;
+            WR_STROBE;
+            WR_STROBE;
+            WR_STROBE;
+            WR_STROBE;
+            WR_STROBE;
+        }
+        while (n-- > 0) {
+            WR_STROBE;
+        }
+    } else {
+        uint32_t d_hi = tft_bsrr_d[hi], e_hi = tft_bsrr_e[hi], f_hi = tft_bsrr_f[hi];
+        uint32_t d_lo = tft_bsrr_d[lo], e_lo = tft_bsrr_e[lo], f_lo = tft_bsrr_f[lo];
+        while (n-- > 0) {
+            GPIOD->BSRR = d_hi;
+            GPIOE->BSRR = e_hi;
+            GPIOF->BSRR = f_hi;
+            WR_STROBE;
+            GPIOD->BSRR = d_lo;
+            GPIOE->BSRR = e_lo;
+            GPIOF->BSRR = f_lo;
+            WR_STROBE;
+        }
+    }
+}
+#endif
+
+ITCM_FUNC void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    CPU_CYCLES_BEGIN(start);
     int16_t end;
 #if defined(SUPPORT_9488_555)
     if (is555) color = color565_to_555(color);
@@ -3271,10 +3370,10 @@ void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
         h = w;
         w = end;
     }
-    uint8_t hi = color >> 8, lo = color & 0xFF;
+#if USING_16BIT_BUS
+    uint8_t hi, lo;
     while (h-- > 0) {
         end = w;
-#if USING_16BIT_BUS
 #if defined(__MK66FX1M0__)      //180MHz M4
 #define STROBE_16BIT {WR_ACTIVE4;WR_ACTIVE;WR_IDLE4;WR_IDLE;}   //56ns
 #elif defined(__SAM3X8E__)      //84MHz M3
@@ -3301,6 +3400,7 @@ void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
         while (lo-- > 0) {
             STROBE_16BIT;
         }
+    }
 #else
 //#if defined(SUPPORT_1289)
 //        if (is9797) {
@@ -3314,15 +3414,13 @@ void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
 //             } while (--end != 0);
 //        } else
 //#endif
-        do {
-            write8(hi);
-            write8(lo);
-        } while (--end != 0);
+    if (w > 0 && h > 0)
+        fillPixels(color, (uint32_t)w * (uint32_t)h);
 #endif
-    }
     CS_IDLE;
     if (!(_lcd_capable & MIPI_DCS_REV1) || ((_lcd_ID == 0x1526) && (rotation & 1)))
         setAddrWindow(0, 0, width() - 1, height() - 1);
+    CPU_CYCLES_END(CPU_CYCLES_FILLRECT, start);
 }
 
 
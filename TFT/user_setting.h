@@ -60,86 +60,100 @@ void delay (uint32_t time);
 
 // configure macros for the data pins.
 
-/* First of all clear all the LCD_DATA pins i.e. LCD_D0 to LCD_D7
- * We do that by writing the HIGHER bits in BSRR Register
+/* The LCD_DATA pins (LCD_D0 to LCD_D7) are scattered over GPIOD, GPIOE and
+ * GPIOF, so every byte is written as one BSRR word per port. The higher bits
+ * of BSRR clear all the data pins of the port, the lower bits set the ones of
+ * the byte, and a set wins over a clear of the same pin, so a single store
+ * moves each port straight to its new value.
  *
- * For example :- To clear Pins B3, B4 , B8, B9, we have to write GPIOB->BSRR = 0b0000001100011000 <<16
- *
- *
- *
- * To write the data to the respective Pins, we have to write the lower bits of BSRR :-
- *
- * For example say the PIN LCD_D4 is connected to PB7, and LCD_D6 is connected to PB2
- *
- * GPIOB->BSRR = (data & (1<<4)) << 3.  Here first select 4th bit of data (LCD_D4), and than again shift left by 3 (Total 4+3 =7 i.e. PB7)
- *
- * GPIOB->BSRR = (data & (1<<6)) >> 4.  Here first select 6th bit of data (LCD_D6), and than again shift Right by 4 (Total 6-4 =2 i.e. PB2)
+ * For example :- with LCD_D4 on PB7 and LCD_D6 on PB2 the word for data is
  *
+ * ((1<<7) | (1<<2)) << 16 | (data & (1<<4)) << 3 | (data & (1<<6)) >> 4
  *
+ * TFT_BSRR_D/E/F(d) are these words for the pin map above, tft.c expands them
+ * into 256-entry tables at compile time so write_8 is three loads and three
+ * stores. Keep them in step with the pin map when rewiring the shield.
  */
+#define TFT_BSRR_D(d)  ((0b1000000000000000u << 16) \
+                       | (((d) & (1u<<1)) << 14))
+#define TFT_BSRR_E(d)  ((0b0010101000000000u << 16) \
+                       | (((d) & (1u<<3)) << 10) \
+                       | (((d) & (1u<<5)) << 6) \
+                       | (((d) & (1u<<6)) << 3))
+#define TFT_BSRR_F(d)  ((0b1111000000000000u << 16) \
+                       | (((d) & (1u<<0)) << 12) \
+                       | (((d) & (1u<<2)) << 13) \
+                       | (((d) & (1u<<4)) << 10) \
+                       | (((d) & (1u<<7)) << 6))
+
+/* Place the bus tables (3 KB write, 48 bytes read) in DTCM, zero wait state
+ * loads next to the stores to the GPIO ports, otherwise they stay in flash */
+#ifndef TFT_BUS_LUT_IN_DTCM
+#define TFT_BUS_LUT_IN_DTCM 1
+#endif
+
+extern const uint32_t tft_bsrr_d[256];
+extern const uint32_t tft_bsrr_e[256];
+extern const uint32_t tft_bsrr_f[256];
+
   #define write_8(d) { \
-   GPIOD->BSRR = 0b1000000000000000 << 16; \
-   GPIOE->BSRR = 0b0010101000000000 << 16; \
-   GPIOF->BSRR = 0b1111000000000000 << 16; \
-   GPIOD->BSRR = (((d) & (1<<1)) << 14);\
-   GPIOE->BSRR = (((d) & (1<<3)) << 10) \
-               | (((d) & (1<<5)) << 6) \
-			   | (((d) & (1<<6)) << 3); \
-   GPIOF->BSRR = (((d) & (1<<0)) << 12) \
-			   | (((d) & (1<<2)) << 13) \
-			   | (((d) & (1<<4)) << 10) \
-			   | (((d) & (1<<7)) << 6); \
+   uint8_t bus_ = (uint8_t)(d); \
+   GPIOD->BSRR = tft_bsrr_d[bus_]; \
+   GPIOE->BSRR = tft_bsrr_e[bus_]; \
+   GPIOF->BSRR = tft_bsrr_f[bus_]; \
     }
 
 
   /* To read the data from the Pins, we have to read the IDR Register
    *
-   * Take the same example say LCD_D4 is connected to PB7, and LCD_D6 is connected to PB2
-   *
-   * To read data we have to do the following
-   *
-   * GPIOB->IDR & (1<<7) >> 3. First read the PIN (1<<7 means we are reading PB7) than shift it to the position, where it is connected to
-   * and in this example, that would be 4 (LCD_D4). (i.e. 7-3=4)
-   *
-   * GPIOB->IDR & (1<<2) << 4. First read the PIN (1<<2 means we are reading PB2) than shift it to the position, where it is connected to
-   * and in this case, that would be 6 (LCD_D6). (i.e. 2+4= 6). Shifting in the same direction
+   * The data pins of a port sit in a narrow window of IDR, PF12~PF15 and
+   * PE9~PE13, so the window is shifted down and used as the index of a small
+   * table holding the LCD_DATA bits of those pins (PE10 and PE12 are don't
+   * care). The single pin on GPIOD is shifted in place.
    *
+   * TFT_READ_E/F(i) are the table entries for a window value i.
    */
-  #define read_8() (         (((GPIOF->IDR & (1<<12)) >> 12) \
-                           | ((GPIOD->IDR & (1<<15)) >> 14) \
-                           | ((GPIOF->IDR & (1<<15)) >> 13) \
-                           | ((GPIOE->IDR & (1<<13)) >> 10) \
-                           | ((GPIOF->IDR & (1<<14)) >> 10) \
-                           | ((GPIOE->IDR & (1<<11)) >> 6) \
-                           | ((GPIOE->IDR & (1<<9)) >> 3) \
-                           | ((GPIOF->IDR & (1<<13)) >> 6)))
-
+#define TFT_READ_E(i)  ((((i) & (1u<<0)) << 6)   /* PE9  -> LCD_D6 */ \
+                       | (((i) & (1u<<2)) << 3)   /* PE11 -> LCD_D5 */ \
+                       | (((i) & (1u<<4)) >> 1))  /* PE13 -> LCD_D3 */
+#define TFT_READ_F(i)  ((((i) & (1u<<0)) >> 0)   /* PF12 -> LCD_D0 */ \
+                       | (((i) & (1u<<1)) << 6)   /* PF13 -> LCD_D7 */ \
+                       | (((i) & (1u<<2)) << 2)   /* PF14 -> LCD_D4 */ \
+                       | (((i) & (1u<<3)) >> 1))  /* PF15 -> LCD_D2 */
 
+extern const uint8_t tft_read_e[32];
+extern const uint8_t tft_read_f[16];
 
-/********************* For 180 MHz *****************************/
-//#define WRITE_DELAY { WR_ACTIVE8; }
-//#define READ_DELAY  { RD_ACTIVE16;}
+  #define read_8() ((uint8_t)(tft_read_f[(GPIOF->IDR >> 12) & 0x0Fu] \
+                           | tft_read_e[(GPIOE->IDR >> 9) & 0x1Fu] \
+                           | ((GPIOD->IDR & (1u<<15)) >> 14)))
 
 
-/************************** For 72 MHZ ****************************/
-//#define WRITE_DELAY { }
-//#define READ_DELAY  { RD_ACTIVE;  }
 
+/*********************** 8080 bus timing *******************************/
 
-/************************** For 100 MHZ ****************************/
-//#define WRITE_DELAY { WR_ACTIVE2; }
-//#define READ_DELAY  { RD_ACTIVE4; }
+/* Core clock, MHz - the strobes are timed in DWT cycles */
+#define TFT_CPU_MHZ        216u
 
+/* Pulse widths in ns (ILI9486/ILI9488 write and frame memory read timing
+ * with a margin for the shield wiring), adjust to a concrete controller:
+ *
+ * TFT_WR_LOW_NS  - WR low, data setup before the rising edge (twrl)
+ * TFT_WR_HIGH_NS - WR high, data hold before the next byte (twrh)
+ * TFT_RD_LOW_NS  - RD low until the data is read (trdl, 355ns frame memory)
+ * TFT_RD_HIGH_NS - RD high between two reads (trdh)
+ */
+#define TFT_WR_LOW_NS      50u
+#define TFT_WR_HIGH_NS     50u
+#define TFT_RD_LOW_NS      400u
+#define TFT_RD_HIGH_NS     100u
 
-/************************** For 216 MHZ ****************************/
-#define WRITE_DELAY { WR_ACTIVE8; WR_ACTIVE8; } //216MHz
-#define IDLE_DELAY  { WR_IDLE4;WR_IDLE4; }
-#define READ_DELAY  { RD_ACTIVE16;RD_ACTIVE16;RD_ACTIVE16;}
-
+#define TFT_CYCLES(ns)     (((ns) * TFT_CPU_MHZ + 999u) / 1000u)
 
-/************************** For 48 MHZ ****************************/
-//#define WRITE_DELAY { }
-//#define READ_DELAY  { }
+#define TFT_WR_LOW_CYCLES  TFT_CYCLES(TFT_WR_LOW_NS)
+#define TFT_WR_HIGH_CYCLES TFT_CYCLES(TFT_WR_HIGH_NS)
+#define TFT_RD_LOW_CYCLES  TFT_CYCLES(TFT_RD_LOW_NS)
+#define TFT_RD_HIGH_CYCLES TFT_CYCLES(TFT_RD_HIGH_NS)
 
 
 /*****************************  DEFINES FOR DIFFERENT TFTs   ****************************************************/